@@ -0,0 +1,310 @@
+#ifndef COMMON_BFS_H
+#define COMMON_BFS_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "graph.h"
+
+// A graph prepared for BFS in both directions
+// in is the transpose of out; in_slot[e] is where in-edge e sits in its source's out list
+class bfs_graph
+{
+public:
+    bfs_graph(): out(nullptr) {}
+
+    void build(const csr_graph &g)
+    {
+        out = &g;
+        int n = g.size();
+        std::vector<int> offset(n+1,0),adj(g.edges()),slot(g.edges());
+        for(int u=0; u<n; u++)
+            for(const int *it=g.begin(u); it!=g.end(u); it++)
+                offset[*it+1]++;
+        for(int v=0; v<n; v++)
+            offset[v+1] += offset[v];
+        std::vector<int> fill(offset.begin(),offset.end()-1);
+        for(int u=0; u<n; u++)
+        {
+            for(const int *it=g.begin(u); it!=g.end(u); it++)
+            {
+                adj[fill[*it]] = u;
+                slot[fill[*it]++] = (int)(it - g.begin(u));
+            }
+        }
+        in_slot.swap(slot);
+        in.assign(n,offset,adj);
+        return;
+    }
+
+    const csr_graph *out;
+    csr_graph in;
+    std::vector<int> in_slot;
+};
+
+// Direction-optimizing BFS (Beamer et al.)
+// Small frontiers are expanded top-down from a queue, large frontiers bottom-up:
+// every unvisited node looks for a parent in the frontier bitmap
+// The parent of a node is always the one a plain queue BFS would pick: the frontier node
+// that comes first in queue order, then the first slot in that node's neighbor list.
+// Bottom-up steps keep this by comparing (rank of parent, slot) and sorting the new frontier.
+// One engine holds the scratch of one search, so use one engine per thread.
+class bfs_engine
+{
+public:
+    // Switch to bottom-up when the frontier has more than 1/ALPHA of the unexplored edges,
+    // back to top-down when the frontier has less than 1/BETA of the nodes
+    static const int ALPHA = 4;
+    static const int BETA = 24;
+
+    bfs_engine(): top_down_steps(0), bottom_up_steps(0), g(nullptr), n(0) {}
+
+    void bind(const bfs_graph &_g)
+    {
+        g = &_g;
+        n = g->out->size();
+        parent.assign(n,-1);
+        level.assign(n,-1);
+        rank.assign(n,0);
+        key.assign(n,0);
+        visited.assign((n+63)/64,0);
+        in_frontier.assign((n+63)/64,0);
+        touched.clear();
+        touched.reserve(n);
+        frontier.reserve(n);
+        next.reserve(n);
+        return;
+    }
+
+    // Search from start; stop after the level where dest is found (dest -1 searches everything)
+    void run(int start,int dest = -1)
+    {
+        clear();
+        const csr_graph &out = *g->out;
+        const csr_graph &in = g->in;
+        long long unexplored = in.edges();
+
+        mark(start,-1,0);
+        unexplored -= in.degree(start);
+        frontier.assign(1,start);
+        rank[start] = 0;
+
+        bool top_down = true;
+        for(int depth=1; !frontier.empty(); depth++)
+        {
+            if(dest >= 0 && reached(dest))
+                break;
+            long long frontier_edges = 0;
+            for(int i=0; i<(int)frontier.size(); i++)
+                frontier_edges += out.degree(frontier[i]);
+
+            if(top_down && frontier_edges * ALPHA > unexplored)
+                top_down = false;
+            else if(!top_down && (long long)frontier.size() * BETA < n)
+                top_down = true;
+
+            next.clear();
+            if(top_down)
+            {
+                top_down_steps++;
+                for(int i=0; i<(int)frontier.size(); i++)
+                {
+                    int u = frontier[i];
+                    for(const int *it=out.begin(u); it!=out.end(u); it++)
+                    {
+                        if(!test(visited,*it))
+                        {
+                            mark(*it,u,depth);
+                            unexplored -= in.degree(*it);
+                            next.push_back(*it);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                bottom_up_steps++;
+                bottom_up(depth);
+                for(int i=0; i<(int)next.size(); i++)
+                    unexplored -= in.degree(next[i]);
+            }
+            for(int i=0; i<(int)next.size(); i++)
+                rank[next[i]] = i;
+            frontier.swap(next);
+        }
+        return;
+    }
+
+    // parent[v] is -1 for the start and for nodes not reached
+    const int *parents() const
+    {
+        return parent.data();
+    }
+    // level[v] is the hop count from the start, -1 if not reached
+    const int *levels() const
+    {
+        return level.data();
+    }
+
+    long long top_down_steps;
+    long long bottom_up_steps;
+
+private:
+    static bool test(const std::vector<uint64_t> &bits,int v)
+    {
+        return (bits[v >> 6] >> (v & 63)) & 1;
+    }
+    bool reached(int v) const
+    {
+        return test(visited,v);
+    }
+    void mark(int v,int p,int depth)
+    {
+        visited[v >> 6] |= (uint64_t)1 << (v & 63);
+        parent[v] = p;
+        level[v] = depth;
+        touched.push_back(v);
+    }
+    // Reset only what the last search touched
+    void clear()
+    {
+        for(int i=0; i<(int)touched.size(); i++)
+        {
+            parent[touched[i]] = -1;
+            level[touched[i]] = -1;
+            visited[touched[i] >> 6] = 0;
+        }
+        touched.clear();
+        return;
+    }
+
+    void bottom_up(int depth)
+    {
+        const csr_graph &in = g->in;
+        for(int i=0; i<(int)frontier.size(); i++)
+            in_frontier[frontier[i] >> 6] |= (uint64_t)1 << (frontier[i] & 63);
+
+        for(int w=0; w<(int)visited.size(); w++)
+        {
+            uint64_t todo = ~visited[w];
+            while(todo)
+            {
+                int v = w * 64 + __builtin_ctzll(todo);
+                todo &= todo - 1;
+                if(v >= n)
+                    break;
+                // Pick the frontier neighbor a queue BFS would reach v from
+                uint64_t best = UINT64_MAX;
+                int best_parent = -1;
+                const int *slot = g->in_slot.data() + in.offsets()[v];
+                for(const int *it=in.begin(v); it!=in.end(v); it++,slot++)
+                {
+                    if(test(in_frontier,*it))
+                    {
+                        uint64_t k = ((uint64_t)rank[*it] << 32) | (uint32_t)*slot;
+                        if(k < best)
+                        {
+                            best = k;
+                            best_parent = *it;
+                        }
+                    }
+                }
+                if(best_parent >= 0)
+                {
+                    mark(v,best_parent,depth);
+                    key[v] = best;
+                    next.push_back(v);
+                }
+            }
+        }
+        for(int i=0; i<(int)frontier.size(); i++)
+            in_frontier[frontier[i] >> 6] = 0;
+
+        // Put the new frontier in the order a queue BFS would have pushed it
+        std::vector<uint64_t> &k = key;
+        std::sort(next.begin(),next.end(),[&k](int a,int b) { return k[a] < k[b]; });
+        return;
+    }
+
+    const bfs_graph *g;
+    int n;
+    std::vector<int> parent;
+    std::vector<int> level;
+    std::vector<int> rank;
+    std::vector<uint64_t> key;
+    std::vector<uint64_t> visited;
+    std::vector<uint64_t> in_frontier;
+    std::vector<int> touched;
+    std::vector<int> frontier;
+    std::vector<int> next;
+};
+
+// Plain queue BFS over the nodes of a node_mask, on the graph as it is
+// Membership is tested as each link is followed, so no copy or transpose of the graph is built;
+// the start node itself may lie outside the mask
+// Parents are the queue BFS parents bfs_engine keeps, over the links into the mask only
+class masked_bfs_engine
+{
+public:
+    masked_bfs_engine(): g(nullptr), mask(nullptr) {}
+
+    void bind(const csr_graph &_g,const node_mask &_mask)
+    {
+        g = &_g;
+        mask = &_mask;
+        parent.assign(g->size(),-1);
+        visited.assign(g->size(),0);
+        queue.clear();
+        queue.reserve(g->size());
+        return;
+    }
+
+    // Search everything start reaches
+    void run(int start)
+    {
+        clear();
+        visited[start] = 1;
+        queue.push_back(start);
+        for(size_t head=0; head<queue.size(); head++)
+        {
+            int u = queue[head];
+            for(const int *it=g->begin(u); it!=g->end(u); it++)
+            {
+                if(!visited[*it] && mask->contains(*it))
+                {
+                    visited[*it] = 1;
+                    parent[*it] = u;
+                    queue.push_back(*it);
+                }
+            }
+        }
+        return;
+    }
+
+    // parent[v] is -1 for the start and for nodes not reached
+    const int *parents() const
+    {
+        return parent.data();
+    }
+
+private:
+    // Reset only what the last search reached
+    void clear()
+    {
+        for(size_t i=0; i<queue.size(); i++)
+        {
+            parent[queue[i]] = -1;
+            visited[queue[i]] = 0;
+        }
+        queue.clear();
+        return;
+    }
+
+    const csr_graph *g;
+    const node_mask *mask;
+    std::vector<int> parent;
+    std::vector<char> visited;
+    std::vector<int> queue;
+};
+
+#endif
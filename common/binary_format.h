@@ -0,0 +1,170 @@
+#ifndef COMMON_BINARY_FORMAT_H
+#define COMMON_BINARY_FORMAT_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <vector>
+#include "graph.h"
+#include "mapped_file.h"
+
+// Binary container for the inputs of hw1, hw2 and hw3
+// All fields are 32-bit little-endian integers:
+//   header      binary_header, 16 words
+//   offsets     nodes+1 words, CSR offsets of the topology
+//   neighbors   2*links words, CSR neighbors in the order the links were read
+//   events[0]   3 words each: flows (flowID source dest) or publishers (time node proxy)
+//   events[1]   3 words each: subscribers (time node publisher), BINARY_PUBSUB only
+// The graph is stored in CSR form, so a loader can use the mapped arrays directly
+const uint32_t BINARY_MAGIC = 0x42504F4F; // "OOPB"
+const uint32_t BINARY_VERSION = 1;
+const uint32_t BINARY_FLOWS = 1;   // hw1 and hw2 input
+const uint32_t BINARY_PUBSUB = 2;  // hw3 input
+
+struct binary_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint32_t flags;
+    uint32_t nodes;
+    uint32_t links;
+    uint32_t duration;  // hw3 only
+    uint32_t events[2]; // flows; or publishers and subscribers
+    uint32_t reserved[7];
+};
+
+// Write a container; events[k] holds 3 words per event
+inline bool write_binary(const char *path,uint32_t kind,const csr_graph &graph,uint32_t duration,
+                         const std::vector<int> events[2])
+{
+    FILE *f = fopen(path,"wb");
+    if(f == nullptr)
+        return false;
+    binary_header h;
+    memset(&h,0,sizeof(h));
+    h.magic = BINARY_MAGIC;
+    h.version = BINARY_VERSION;
+    h.kind = kind;
+    h.nodes = graph.size();
+    h.links = graph.edges() / 2;
+    h.duration = duration;
+    h.events[0] = events[0].size() / 3;
+    h.events[1] = events[1].size() / 3;
+    bool ok = fwrite(&h,sizeof(h),1,f) == 1;
+    ok = ok && fwrite(graph.offsets(),sizeof(int),graph.size() + 1,f) == (size_t)graph.size() + 1;
+    ok = ok && fwrite(graph.neighbors(),sizeof(int),graph.edges(),f) == (size_t)graph.edges();
+    for(int k=0; k<2; k++)
+        ok = ok && fwrite(events[k].data(),sizeof(int),events[k].size(),f) == events[k].size();
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+// Memory-map a container and check that it is complete and its graph is well formed
+// Nothing is parsed: the graph arrays and the events point into the mapping
+class binary_input
+{
+public:
+    binary_input(): header(nullptr), words(nullptr), reason("") {}
+
+    // False with error() set when the file cannot be used
+    bool open(const char *path,uint32_t kind)
+    {
+        words = nullptr;
+        if(!file.open(path))
+            return fail("cannot map the file");
+        if(file.size() < sizeof(binary_header))
+            return fail("the file is shorter than the header");
+        header = (const binary_header *)file.begin();
+        if(header->magic != BINARY_MAGIC || header->version != BINARY_VERSION)
+            return fail("not a container of this version");
+        if(header->kind != kind)
+            return fail("the container holds the input of another program");
+        // csr_graph counts nodes and neighbors with int
+        if(header->nodes >= (uint32_t)INT_MAX || header->links > (uint32_t)(INT_MAX / 2))
+            return fail("too many nodes or links");
+        size_t count = (size_t)header->nodes + 1 + 2 * (size_t)header->links
+                       + 3 * ((size_t)header->events[0] + header->events[1]);
+        if(file.size() != sizeof(binary_header) + count * sizeof(int))
+            return fail("the file size does not match the header");
+        words = (const int *)(file.begin() + sizeof(binary_header));
+        if(!valid_graph())
+        {
+            words = nullptr;
+            return fail("the graph arrays are damaged");
+        }
+        return true;
+    }
+    // Why the last open failed
+    const char *error() const
+    {
+        return reason;
+    }
+
+    int nodes() const
+    {
+        return header->nodes;
+    }
+    // CSR arrays of the topology, see csr_graph::view
+    const int *offsets() const
+    {
+        return words;
+    }
+    const int *neighbors() const
+    {
+        return words + header->nodes + 1;
+    }
+    int duration() const
+    {
+        return header->duration;
+    }
+    int event_count(int k) const
+    {
+        return header->events[k];
+    }
+    // Event i of list k as 3 words
+    const int *event(int k,int i) const
+    {
+        const int *first = words + header->nodes + 1 + 2 * (size_t)header->links;
+        if(k == 1)
+            first += 3 * (size_t)header->events[0];
+        return first + 3 * (size_t)i;
+    }
+
+private:
+    bool fail(const char *why)
+    {
+        reason = why;
+        file.close();
+        return false;
+    }
+    // Offsets start at 0, never decrease and end at the neighbor count;
+    // every neighbor is a node id
+    bool valid_graph() const
+    {
+        int n = header->nodes;
+        int edges = 2 * header->links;
+        const int *off = offsets(),*nb = neighbors();
+        if(off[0] != 0 || off[n] != edges)
+            return false;
+        for(int v=0; v<n; v++)
+        {
+            if(off[v+1] < off[v])
+                return false;
+        }
+        for(int e=0; e<edges; e++)
+        {
+            if(nb[e] < 0 || nb[e] >= n)
+                return false;
+        }
+        return true;
+    }
+
+    mapped_file file;
+    const binary_header *header;
+    const int *words;
+    const char *reason;
+};
+
+#endif
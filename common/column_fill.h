@@ -0,0 +1,64 @@
+#ifndef COMMON_COLUMN_FILL_H
+#define COMMON_COLUMN_FILL_H
+
+#include <vector>
+#include <algorithm>
+#include "bfs.h"
+#include "dial.h"
+#include "routing_table.h"
+#include "thread_pool.h"
+
+// The hop counts of the engine's last search; the weighted engine has none
+inline const int *hop_levels(const bfs_engine &engine)
+{
+    return engine.levels();
+}
+inline const int *hop_levels(const dial_engine &)
+{
+    return nullptr;
+}
+
+// Fill the columns of table from the trees the engines find, one block of columns per job
+// The tree rooted at dest gives every node's next hop toward dest; engines holds one engine
+// per pool worker, bound to the graph already
+// A block is one 64-byte cache line of a row; the job searches all its trees first and then
+// writes every row's span at once, so workers never write into each other's lines column by
+// column (only the lines a span straddles when a row does not start on a line are shared)
+// hops, if given, gets the hop count of every (node, dest) pair from the same searches
+template<class Engine>
+void fill_columns(int n,std::vector<Engine> &engines,routing_matrix &table,thread_pool &pool,routing_matrix *hops = nullptr)
+{
+    const int block = 64 / routing_matrix::entry_width(n);
+    std::vector<std::vector<int>> trees(pool.size()),levels(pool.size());
+    pool.run((n + block - 1) / block,1,[&](int worker,int k)
+    {
+        int first = k * block;
+        int count = std::min(block,n - first);
+        std::vector<int> &tree = trees[worker];
+        tree.resize((size_t)block * n);
+        if(hops != nullptr)
+            levels[worker].resize((size_t)block * n);
+        for(int b=0; b<count; b++)
+        {
+            engines[worker].run(first + b);
+            const int *last_node = engines[worker].parents();
+            std::copy(last_node,last_node + n,tree.begin() + (size_t)b * n);
+            const int *level = (hops != nullptr) ? hop_levels(engines[worker]) : nullptr;
+            if(level != nullptr)
+                std::copy(level,level + n,levels[worker].begin() + (size_t)b * n);
+        }
+        for(int i=0; i<n; i++)
+        {
+            for(int b=0; b<count; b++)
+                table.set(i,first + b,(i != first + b) ? tree[(size_t)b * n + i] : first + b);
+            if(hops != nullptr)
+            {
+                for(int b=0; b<count; b++)
+                    hops->set(i,first + b,levels[worker][(size_t)b * n + i]);
+            }
+        }
+    });
+    return;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef COMMON_COMPACT_ROUTING_H
+#define COMMON_COMPACT_ROUTING_H
+
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include "graph.h"
+#include "bfs.h"
+#include "router.h"
+#include "routing_table.h"
+#include "column_fill.h"
+#include "thread_pool.h"
+
+// Routing tables kept as runs of equal next hops
+// Destinations are relabelled in DFS preorder, so every subtree of the DFS tree is one
+// interval of labels and the next hops of a row mostly come in long runs
+// Row u keeps (first label, next hop) for every run; a lookup is a binary search in the row
+// All rows are one flat array of entries as wide as routing_matrix's, so the runs are counted
+// first and written in place by a second sweep. When they would not be smaller than the dense
+// routing_matrix the dense one is built instead; dense() tells which one was picked
+// Paths are the same as build_routing_table's: the same BFS builds every column
+class compact_router : public router
+{
+public:
+    compact_router(): n(0), width(0), use_dense(false) {}
+
+    void build(const csr_graph &graph,thread_pool &pool)
+    {
+        n = graph.size();
+        width = routing_matrix::entry_width(n);
+        relabel(graph);
+        bfs_graph bgraph;
+        bgraph.build(graph);
+        std::vector<bfs_engine> engines(pool.size());
+        for(int w=0; w<pool.size(); w++)
+            engines[w].bind(bgraph);
+
+        // Every worker sweeps a contiguous range of labels and counts the runs of every row in it
+        int parts = std::min(pool.size(),std::max(n,1));
+        std::vector<std::vector<int>> first_hop(parts),last_hop(parts);
+        std::vector<std::vector<size_t>> offset(parts);
+        pool.run(parts,1,[&](int worker,int part)
+        {
+            first_hop[part].resize(n);
+            last_hop[part].assign(n,INT_MIN);
+            offset[part].assign(n,0);
+            sweep(engines[worker],part,parts,last_hop[part],[&](int i,int label,int hop)
+            {
+                if(label == part_begin(part,parts))
+                    first_hop[part][i] = hop;
+                offset[part][i]++;
+            });
+        });
+        // A run that continues across a part boundary is counted once
+        row_begin.assign(n + 1,0);
+        size_t total = 0;
+        for(int i=0; i<n; i++)
+        {
+            row_begin[i] = total;
+            for(int p=0; p<parts; p++)
+            {
+                size_t count = offset[p][i];
+                if(p > 0 && last_hop[p-1][i] == first_hop[p][i])
+                    count--;
+                offset[p][i] = total;
+                total += count;
+            }
+        }
+        row_begin[n] = total;
+        std::vector<std::vector<int>>().swap(first_hop);
+
+        use_dense = total * 2 * width + row_begin.size() * sizeof(size_t) + label_of.size() * sizeof(int) >=
+                    (size_t)n * n * width;
+        if(use_dense)
+        {
+            std::vector<std::vector<int>>().swap(last_hop);
+            std::vector<std::vector<size_t>>().swap(offset);
+            std::vector<size_t>().swap(row_begin);
+            std::vector<int>().swap(label_of);
+            std::vector<int>().swap(order);
+            dense_table.build(n);
+            fill_columns(n,engines,dense_table,pool);
+            return;
+        }
+
+        // Write the runs in place; a part starts from the last hops of the part before it,
+        // so the run continuing across the boundary is not written twice
+        start_cells.assign(total * width,0);
+        hop_cells.assign(total * width,0);
+        pool.run(parts,1,[&](int worker,int part)
+        {
+            std::vector<int> last = (part > 0) ? last_hop[part-1] : std::vector<int>(n,INT_MIN);
+            std::vector<size_t> &at = offset[part];
+            sweep(engines[worker],part,parts,last,[&](int i,int label,int hop)
+            {
+                routing_matrix::encode(&start_cells[at[i] * width],width,label);
+                routing_matrix::encode(&hop_cells[at[i] * width],width,hop);
+                at[i]++;
+            });
+        });
+        std::vector<int>().swap(order);
+        return;
+    }
+
+    unsigned int next_hop(int node,int dest)
+    {
+        if(use_dense)
+            return dense_table.get(node,dest);
+        // The last run of the row starting at or before the label
+        unsigned int label = (unsigned int)label_of[dest];
+        size_t low = row_begin[node],high = row_begin[node + 1];
+        while(high - low > 1)
+        {
+            size_t mid = low + (high - low) / 2;
+            if(routing_matrix::decode(&start_cells[mid * width],width) <= label)
+                low = mid;
+            else
+                high = mid;
+        }
+        return routing_matrix::decode(&hop_cells[low * width],width);
+    }
+
+    bool dense() const
+    {
+        return use_dense;
+    }
+    size_t bytes() const
+    {
+        if(use_dense)
+            return dense_table.bytes();
+        return start_cells.size() + hop_cells.size() +
+               row_begin.size() * sizeof(size_t) + label_of.size() * sizeof(int);
+    }
+    size_t runs() const
+    {
+        return use_dense ? 0 : row_begin[n];
+    }
+
+private:
+    int part_begin(int part,int parts) const
+    {
+        return (int)((long long)n * part / parts);
+    }
+
+    // Search from the destinations of one part in label order and call emit(row, label, hop)
+    // for every label where a row's next hop differs from last[row]
+    template<class F>
+    void sweep(bfs_engine &engine,int part,int parts,std::vector<int> &last,F emit)
+    {
+        int first = part_begin(part,parts);
+        int end = part_begin(part + 1,parts);
+        for(int label=first; label<end; label++)
+        {
+            int dest = order[label];
+            engine.run(dest);
+            const int *last_node = engine.parents();
+            for(int i=0; i<n; i++)
+            {
+                int hop = (i != dest) ? last_node[i] : dest;
+                if(hop != last[i])
+                {
+                    emit(i,label,hop);
+                    last[i] = hop;
+                }
+            }
+        }
+        return;
+    }
+
+    // DFS preorder over every component, neighbors taken in adjacency order
+    void relabel(const csr_graph &graph)
+    {
+        order.clear();
+        order.reserve(n);
+        label_of.assign(n,-1);
+        std::vector<int> stack;
+        std::vector<const int*> cursor(n);
+        for(int root=0; root<n; root++)
+        {
+            if(label_of[root] >= 0)
+                continue;
+            label_of[root] = (int)order.size();
+            order.push_back(root);
+            cursor[root] = graph.begin(root);
+            stack.push_back(root);
+            while(!stack.empty())
+            {
+                int u = stack.back();
+                if(cursor[u] == graph.end(u))
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                int v = *cursor[u]++;
+                if(label_of[v] >= 0)
+                    continue;
+                label_of[v] = (int)order.size();
+                order.push_back(v);
+                cursor[v] = graph.begin(v);
+                stack.push_back(v);
+            }
+        }
+        return;
+    }
+
+    int n;
+    int width;                              // bytes per stored label or hop
+    bool use_dense;
+    std::vector<int> label_of;              // node -> DFS label
+    std::vector<int> order;                 // DFS label -> node
+    std::vector<size_t> row_begin;
+    std::vector<unsigned char> start_cells; // first label of every run
+    std::vector<unsigned char> hop_cells;   // next hop of every run, NONE if unreachable
+    routing_matrix dense_table;             // used instead of the runs when they are not smaller
+};
+
+#endif
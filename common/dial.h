@@ -0,0 +1,174 @@
+#ifndef COMMON_DIAL_H
+#define COMMON_DIAL_H
+
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <climits>
+#include <functional>
+#include <algorithm>
+#include "graph.h"
+
+// Dijkstra over small non-negative integer link weights with a bucket queue (Dial's algorithm)
+// Bucket d % (max weight + 1) holds the nodes at tentative distance d; a relaxation never
+// reaches more than max weight past the current distance, so the buckets never collide
+// Every step is a bucket push or pop, which keeps it close to BFS for small weights
+// Weights of n or more would need more buckets than nodes, so those graphs use a binary heap
+// ordered by (distance, push order) instead; it settles the nodes in the same order as the buckets
+// Distances are summed in 64 bits, so any non-negative int weight is safe
+// parent[v] is the node whose relaxation first gave v its final distance
+// Bound with a node_mask, it only relaxes the links into the mask, like masked_bfs_engine
+class dial_engine
+{
+public:
+    dial_engine(): g(nullptr), weight(nullptr), mask(nullptr), n(0) {}
+
+    // weight holds one weight per adjacency slot of g, see csr_graph::slot_values
+    void bind(const csr_graph &_g,const int *_weight,const node_mask *_mask = nullptr)
+    {
+        g = &_g;
+        weight = _weight;
+        mask = _mask;
+        n = g->size();
+        int max_weight = 0;
+        for(int i=0; i<g->edges(); i++)
+            max_weight = std::max(max_weight,weight[i]);
+        if(max_weight < std::max(n,1))
+            buckets.assign(max_weight + 1,std::vector<int>());
+        else
+            buckets.clear();
+        dist.assign(n,INF);
+        parent.assign(n,-1);
+        done.assign(n,0);
+        touched.clear();
+        touched.reserve(n);
+        return;
+    }
+
+    // Search from start; stop once dest is settled (dest -1 searches everything)
+    void run(int start,int dest = -1)
+    {
+        clear();
+        dist[start] = 0;
+        touched.push_back(start);
+        if(buckets.empty())
+        {
+            run_heap(start,dest);
+            return;
+        }
+        const int B = (int)buckets.size();
+        buckets[0].push_back(start);
+        long long pending = 1;
+        for(long long d=0; pending > 0; d++)
+        {
+            // A zero weight link adds to the bucket being drained
+            std::vector<int> &bucket = buckets[d % B];
+            for(size_t k=0; k<bucket.size(); k++)
+            {
+                int u = bucket[k];
+                pending--;
+                if(done[u] || dist[u] != d)
+                    continue;
+                done[u] = 1;
+                if(u == dest)
+                {
+                    pending = 0;
+                    break;
+                }
+                const int *w = weight + (g->begin(u) - g->neighbors());
+                for(const int *it=g->begin(u); it!=g->end(u); it++,w++)
+                {
+                    long long nd = d + *w;
+                    if(relax(u,*it,nd))
+                    {
+                        buckets[nd % B].push_back(*it);
+                        pending++;
+                    }
+                }
+            }
+            bucket.clear();
+        }
+        for(int b=0; b<B; b++)
+            buckets[b].clear();
+        return;
+    }
+
+    // parent[v] is -1 for the start and for nodes not reached
+    const int *parents() const
+    {
+        return parent.data();
+    }
+    // dist[v] is the path weight from the start, INF if not reached
+    const long long *distances() const
+    {
+        return dist.data();
+    }
+
+    static constexpr long long INF = LLONG_MAX;
+
+private:
+    // Equal distances pop in push order, as they leave a bucket
+    void run_heap(int start,int dest)
+    {
+        typedef std::tuple<long long,long long,int> item;
+        std::priority_queue<item,std::vector<item>,std::greater<item> > heap;
+        long long pushes = 0;
+        heap.push(item(0,pushes++,start));
+        while(!heap.empty())
+        {
+            long long d = std::get<0>(heap.top());
+            int u = std::get<2>(heap.top());
+            heap.pop();
+            if(done[u] || dist[u] != d)
+                continue;
+            done[u] = 1;
+            if(u == dest)
+                break;
+            const int *w = weight + (g->begin(u) - g->neighbors());
+            for(const int *it=g->begin(u); it!=g->end(u); it++,w++)
+            {
+                long long nd = d + *w;
+                if(relax(u,*it,nd))
+                    heap.push(item(nd,pushes++,*it));
+            }
+        }
+        return;
+    }
+    // Whether the link u-v gives v the shorter distance nd
+    bool relax(int u,int v,long long nd)
+    {
+        if(nd >= dist[v] || (mask != nullptr && !mask->contains(v)))
+            return false;
+        if(dist[v] == INF)
+            touched.push_back(v);
+        dist[v] = nd;
+        parent[v] = u;
+        return true;
+    }
+
+    // Reset only what the last search touched
+    void clear()
+    {
+        for(int i=0; i<(int)touched.size(); i++)
+        {
+            int v = touched[i];
+            dist[v] = INF;
+            parent[v] = -1;
+            done[v] = 0;
+        }
+        touched.clear();
+        return;
+    }
+
+    const csr_graph *g;
+    const int *weight;
+    const node_mask *mask;
+    int n;
+    std::vector<std::vector<int>> buckets;
+    std::vector<long long> dist;
+    std::vector<int> parent;
+    std::vector<char> done;
+    std::vector<int> touched;
+};
+
+#endif
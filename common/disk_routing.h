@@ -0,0 +1,330 @@
+#ifndef COMMON_DISK_ROUTING_H
+#define COMMON_DISK_ROUTING_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include "graph.h"
+#include "bfs.h"
+#include "router.h"
+#include "routing_table.h"
+#include "thread_pool.h"
+#include "table_snapshot.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Routing tables kept on disk for topologies whose n x n table does not fit in memory
+//   header   disk_table_header, 48 bytes
+//   columns  column dest is the next hop of every node toward dest, n entries of width bytes
+// The columns are computed a block at a time, as many as fit in the memory budget, and
+// appended to the file; lookups read fixed-size pages through an LRU page cache of the
+// same budget, never more pages than the file has, so the table itself never takes more than
+// the budget. Computing the columns also needs the transposed graph (about 16 bytes per link)
+// and one BFS engine per thread (about 32 bytes per node), which are not counted against it
+// Walking a path toward dest stays in dest's column, so most hops hit a cached page
+// The budget must hold one column and one page, see min_budget
+// The cache is split into stripes, each with its own lock and LRU list; page p lives in
+// stripe p % stripes, so lookups of different pages seldom wait for each other
+// A file built from the same topology is reused without computing anything
+const uint32_t DISK_TABLE_MAGIC = 0x44504F4F; // "OOPD"
+const uint32_t DISK_TABLE_VERSION = 1;
+
+struct disk_table_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodes;
+    uint32_t width;       // bytes per entry
+    uint64_t fingerprint; // topology_fingerprint of the graph
+    uint64_t reserved[3];
+};
+
+class disk_router : public router
+{
+public:
+    static const size_t PAGE = 1 << 16;
+    static const int STRIPES = 16;
+
+    disk_router(): n(0), width(0), fd(-1), file(nullptr), stripe_count(0) {}
+    ~disk_router()
+    {
+        close();
+    }
+
+    // Open the table at path, computing it first unless it was built from graph already
+    // budget bounds the memory of the column blocks and of the page cache, and must be
+    // at least min_budget(graph.size()); the BFS scratch of the build comes on top
+    bool build(const char *path,const csr_graph &graph,size_t budget,thread_pool &pool,bool &reused)
+    {
+        close();
+        if(budget < min_budget(graph.size()))
+            return false;
+        n = graph.size();
+        width = routing_matrix::entry_width(n);
+        uint64_t fingerprint = topology_fingerprint(graph);
+        reused = matches(path,fingerprint);
+        if(!reused && !write_table(path,graph,fingerprint,budget,pool))
+            return false;
+        if(!open_file(path))
+            return false;
+        uint64_t file_pages = (sizeof(disk_table_header) + (uint64_t)n * n * width + PAGE - 1) / PAGE;
+        int slots = (int)std::min((uint64_t)(budget / PAGE),file_pages);
+        cache.assign((size_t)slots * PAGE,0);
+        stripe_count = std::min((int)STRIPES,slots);
+        stripes = std::vector<stripe>(stripe_count);
+        for(int k=0; k<stripe_count; k++)
+        {
+            stripe &s = stripes[k];
+            s.first = (int)((long long)slots * k / stripe_count);
+            int count = (int)((long long)slots * (k + 1) / stripe_count) - s.first;
+            s.page_of.assign(count,-1);
+            s.prev.assign(count,-1);
+            s.next.assign(count,-1);
+        }
+        return true;
+    }
+
+    // One page for the cache and one column for building the table
+    static size_t min_budget(int n)
+    {
+        return std::max((size_t)PAGE,(size_t)n * routing_matrix::entry_width(n));
+    }
+
+    unsigned int next_hop(int node,int dest)
+    {
+        if(node == dest)
+            return dest;
+        uint64_t offset = sizeof(disk_table_header) + ((uint64_t)dest * n + node) * width;
+        long long number = offset / PAGE;
+        stripe &s = stripes[number % stripe_count];
+        std::lock_guard<std::mutex> lock(s.guard);
+        // An entry never straddles two pages: PAGE is a multiple of every width
+        return routing_matrix::decode(page(s,number) + offset % PAGE,width);
+    }
+
+    size_t bytes() const
+    {
+        return cache.size();
+    }
+    int pages() const
+    {
+        return (int)(cache.size() / PAGE);
+    }
+    // Call these when no lookup is running
+    long long hits() const
+    {
+        long long count = 0;
+        for(int k=0; k<stripe_count; k++)
+            count += stripes[k].hits;
+        return count;
+    }
+    long long misses() const
+    {
+        long long count = 0;
+        for(int k=0; k<stripe_count; k++)
+            count += stripes[k].misses;
+        return count;
+    }
+
+private:
+    // Slots first .. first + page_of.size() - 1 of the cache, most recently used page at head
+    struct stripe
+    {
+        stripe(): first(0), head(-1), tail(-1), used(0), hits(0), misses(0) {}
+
+        std::mutex guard;
+        int first;
+        std::vector<long long> page_of;  // slot - first -> page number
+        std::vector<int> prev;
+        std::vector<int> next;
+        std::unordered_map<long long,int> slot_of;
+        int head;
+        int tail;
+        int used;
+        long long hits;
+        long long misses;
+    };
+
+    disk_router(const disk_router &) = delete; // lock the copy constructor
+    disk_router &operator=(const disk_router &) = delete; // and the copy assignment
+
+    bool matches(const char *path,uint64_t fingerprint)
+    {
+        FILE *f = fopen(path,"rb");
+        if(f == nullptr)
+            return false;
+        disk_table_header h;
+        bool ok = fread(&h,sizeof(h),1,f) == 1 && h.magic == DISK_TABLE_MAGIC &&
+                  h.version == DISK_TABLE_VERSION && h.nodes == (uint32_t)n &&
+                  h.width == (uint32_t)width && h.fingerprint == fingerprint;
+        if(ok)
+        {
+            // The table must be complete
+            fseek(f,0,SEEK_END);
+            long long size = ftell(f);
+            ok = size >= 0 && (uint64_t)size == sizeof(h) + (uint64_t)n * n * width;
+        }
+        fclose(f);
+        return ok;
+    }
+
+    // Compute the columns block by block and append them to path
+    bool write_table(const char *path,const csr_graph &graph,uint64_t fingerprint,size_t budget,thread_pool &pool)
+    {
+        std::string temp = std::string(path) + ".tmp";
+        FILE *f = fopen(temp.c_str(),"wb");
+        if(f == nullptr)
+            return false;
+        disk_table_header h;
+        memset(&h,0,sizeof(h));
+        h.magic = DISK_TABLE_MAGIC;
+        h.version = DISK_TABLE_VERSION;
+        h.nodes = n;
+        h.width = width;
+        h.fingerprint = fingerprint;
+        bool ok = fwrite(&h,sizeof(h),1,f) == 1;
+
+        size_t column = (size_t)n * width;
+        int block = (int)std::max((size_t)1,std::min((size_t)std::max(n,1),budget / std::max((size_t)1,column)));
+        routing_matrix columns; // row k is the column of dest first + k
+        columns.build(n,block);
+        bfs_graph bgraph;
+        bgraph.build(graph);
+        std::vector<bfs_engine> engines(pool.size());
+        for(int i=0; i<pool.size(); i++)
+            engines[i].bind(bgraph);
+        for(int first=0; ok && first<n; first+=block)
+        {
+            int count = std::min(block,n - first);
+            pool.run(count,1,[&](int worker,int k)
+            {
+                int dest = first + k;
+                engines[worker].run(dest);
+                const int *last_node = engines[worker].parents();
+                for(int i=0; i<n; i++)
+                    columns.set(k,i,(i != dest) ? last_node[i] : dest);
+            });
+            ok = fwrite(columns.cells(),1,(size_t)count * column,f) == (size_t)count * column;
+        }
+        ok = (fclose(f) == 0) && ok;
+        if(ok)
+            ok = rename(temp.c_str(),path) == 0;
+        if(!ok)
+            remove(temp.c_str());
+        return ok;
+    }
+
+    bool open_file(const char *path)
+    {
+#ifndef _WIN32
+        fd = ::open(path,O_RDONLY);
+        return fd >= 0;
+#else
+        file = fopen(path,"rb");
+        return file != nullptr;
+#endif
+    }
+    void close()
+    {
+#ifndef _WIN32
+        if(fd >= 0)
+            ::close(fd);
+#else
+        if(file != nullptr)
+            fclose(file);
+#endif
+        fd = -1;
+        file = nullptr;
+        return;
+    }
+
+    // The cached copy of page number, read from the file on a miss; s must be locked
+    const unsigned char *page(stripe &s,long long number)
+    {
+        auto found = s.slot_of.find(number);
+        int slot;
+        if(found != s.slot_of.end())
+        {
+            s.hits++;
+            slot = found->second;
+            unlink(s,slot);
+        }
+        else
+        {
+            s.misses++;
+            if(s.used < (int)s.page_of.size())
+                slot = s.used++;
+            else
+            {
+                slot = s.tail;
+                unlink(s,slot);
+                s.slot_of.erase(s.page_of[slot]);
+            }
+            read_page(number,&cache[(size_t)(s.first + slot) * PAGE]);
+            s.slot_of[number] = slot;
+            s.page_of[slot] = number;
+        }
+        push_front(s,slot);
+        return &cache[(size_t)(s.first + slot) * PAGE];
+    }
+    // The last page of the file is short; the rest of its copy is never looked at
+    void read_page(long long number,unsigned char *to)
+    {
+#ifndef _WIN32
+        size_t done = 0;
+        while(done < PAGE)
+        {
+            ssize_t got = pread(fd,to + done,PAGE - done,number * PAGE + done);
+            if(got <= 0)
+                break;
+            done += got;
+        }
+#else
+        _fseeki64(file,number * PAGE,SEEK_SET);
+        fread(to,1,PAGE,file);
+#endif
+        return;
+    }
+
+    void unlink(stripe &s,int slot)
+    {
+        if(s.prev[slot] >= 0)
+            s.next[s.prev[slot]] = s.next[slot];
+        else
+            s.head = s.next[slot];
+        if(s.next[slot] >= 0)
+            s.prev[s.next[slot]] = s.prev[slot];
+        else
+            s.tail = s.prev[slot];
+        s.prev[slot] = s.next[slot] = -1;
+        return;
+    }
+    void push_front(stripe &s,int slot)
+    {
+        s.prev[slot] = -1;
+        s.next[slot] = s.head;
+        if(s.head >= 0)
+            s.prev[s.head] = slot;
+        s.head = slot;
+        if(s.tail < 0)
+            s.tail = slot;
+        return;
+    }
+
+    int n;
+    int width;
+    int fd;
+    FILE *file;
+    std::vector<unsigned char> cache; // page slots, PAGE bytes each
+    std::vector<stripe> stripes;
+    int stripe_count;
+};
+
+#endif
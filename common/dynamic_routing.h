@@ -0,0 +1,250 @@
+#ifndef COMMON_DYNAMIC_ROUTING_H
+#define COMMON_DYNAMIC_ROUTING_H
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <functional>
+#include "graph.h"
+#include "routing_table.h"
+#include "thread_pool.h"
+
+// Keep hop-count routing tables up to date while links are added and removed
+// Next to the next-hop matrix it keeps the hop distance of every (node, dest) pair,
+// and on a link change it repairs only the BFS trees the change can affect:
+//   add a-b    : only trees where a and b are 2+ levels apart; the distances which shrink are
+//                pushed outward from the far endpoint
+//   remove a-b : only trees where a-b is a tree edge; the subtree below it is cut off and
+//                its distances are rebuilt from the nodes around it
+// A repaired node takes its first neighbor one level closer as next hop; nodes whose
+// distance does not change keep their next hop, so the result can break ties differently
+// from a fresh build but every path is still a shortest path
+class dynamic_routing
+{
+public:
+    dynamic_routing(): n(0), table(nullptr), pool(nullptr) {}
+
+    // table must already hold the routing tables of the graph made of the links nodeA[i]-nodeB[i],
+    // and hops the hop count of every (node, dest) pair, as the table builder recorded them
+    // hops is taken over and left empty, so nothing is searched again
+    void build(int _n,const std::vector<int> &_nodeA,const std::vector<int> &_nodeB,routing_matrix *_table,thread_pool *_pool,
+               routing_matrix &hops)
+    {
+        n = _n;
+        nodeA = _nodeA;
+        nodeB = _nodeB;
+        table = _table;
+        pool = _pool;
+        graph.build(n,nodeA,nodeB);
+        dist = std::move(hops);
+        hops = routing_matrix();
+        scratch.assign(pool->size(),repair_scratch());
+        for(int i=0; i<pool->size(); i++)
+            scratch[i].in_subtree.assign(n,0);
+        return;
+    }
+
+    // Both return how many next-hop entries changed, or -1 when a or b is not a node
+    long long add_link(int a,int b)
+    {
+        if(!valid(a) || !valid(b))
+            return -1;
+        nodeA.push_back(a);
+        nodeB.push_back(b);
+        graph.build(n,nodeA,nodeB);
+        if(a == b)
+            return 0;
+        return repair([&](int worker,int dest)
+        {
+            return repair_add(scratch[worker],a,b,dest);
+        });
+    }
+    long long remove_link(int a,int b)
+    {
+        if(!valid(a) || !valid(b))
+            return -1;
+        int i = 0;
+        while(i < (int)nodeA.size() && !((nodeA[i] == a && nodeB[i] == b) || (nodeA[i] == b && nodeB[i] == a)))
+            i++;
+        if(i == (int)nodeA.size())
+            return 0;
+        nodeA.erase(nodeA.begin() + i);
+        nodeB.erase(nodeB.begin() + i);
+        graph.build(n,nodeA,nodeB);
+        if(a == b)
+            return 0;
+        // A parallel link keeps every tree as it is
+        for(const int *it=graph.begin(a); it!=graph.end(a); it++)
+            if(*it == b)
+                return 0;
+        return repair([&](int worker,int dest)
+        {
+            return repair_remove(scratch[worker],a,b,dest);
+        });
+    }
+
+    const csr_graph &topology() const
+    {
+        return graph;
+    }
+
+private:
+    static const unsigned int INF = routing_matrix::NONE;
+
+    bool valid(int v) const
+    {
+        return v >= 0 && v < n;
+    }
+
+    struct repair_scratch
+    {
+        std::vector<char> in_subtree;
+        std::vector<int> nodes;
+        long long changed;
+    };
+
+    template<class F>
+    long long repair(F one_tree)
+    {
+        for(int i=0; i<(int)scratch.size(); i++)
+            scratch[i].changed = 0;
+        pool->run(n,64,[&](int worker,int dest)
+        {
+            scratch[worker].changed += one_tree(worker,dest);
+        });
+        long long changed = 0;
+        for(int i=0; i<(int)scratch.size(); i++)
+            changed += scratch[i].changed;
+        return changed;
+    }
+
+    // Point every node in s.nodes at its first neighbor one level closer to dest
+    long long relink(repair_scratch &s,int dest)
+    {
+        long long changed = 0;
+        for(int i=0; i<(int)s.nodes.size(); i++)
+        {
+            int v = s.nodes[i];
+            unsigned int d = dist.get(v,dest);
+            int hop = -1;
+            if(d != INF)
+            {
+                for(const int *it=graph.begin(v); it!=graph.end(v) && hop < 0; it++)
+                    if(dist.get(*it,dest) + 1 == d)
+                        hop = *it;
+            }
+            if(table->get(v,dest) != (unsigned int)hop)
+            {
+                table->set(v,dest,hop);
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    long long repair_add(repair_scratch &s,int a,int b,int dest)
+    {
+        unsigned int da = dist.get(a,dest),db = dist.get(b,dest);
+        if(da > db)
+        {
+            std::swap(a,b);
+            std::swap(da,db);
+        }
+        // b can only get closer if it is 2+ levels below a
+        if(da == INF || (db != INF && da + 1 >= db))
+            return 0;
+
+        s.nodes.clear();
+        dist.set(b,dest,da + 1);
+        s.nodes.push_back(b);
+        for(int i=0; i<(int)s.nodes.size(); i++)
+        {
+            int v = s.nodes[i];
+            unsigned int dv = dist.get(v,dest);
+            for(const int *it=graph.begin(v); it!=graph.end(v); it++)
+            {
+                if(dv + 1 < dist.get(*it,dest))
+                {
+                    dist.set(*it,dest,dv + 1);
+                    s.nodes.push_back(*it);
+                }
+            }
+        }
+        // A node may be pushed again when it gets closer twice; relink looks at final distances
+        return relink(s,dest);
+    }
+
+    long long repair_remove(repair_scratch &s,int a,int b,int dest)
+    {
+        if(table->get(a,dest) == (unsigned int)b)
+            std::swap(a,b);
+        // b must hang below a in the tree of dest
+        if(table->get(b,dest) != (unsigned int)a)
+            return 0;
+
+        // Cut off the subtree below b
+        s.nodes.assign(1,b);
+        s.in_subtree[b] = 1;
+        for(int i=0; i<(int)s.nodes.size(); i++)
+        {
+            int v = s.nodes[i];
+            for(const int *it=graph.begin(v); it!=graph.end(v); it++)
+            {
+                if(!s.in_subtree[*it] && table->get(*it,dest) == (unsigned int)v)
+                {
+                    s.in_subtree[*it] = 1;
+                    s.nodes.push_back(*it);
+                }
+            }
+        }
+
+        // Distances through the nodes around the subtree, then shortest paths inside it
+        typedef std::pair<unsigned int,int> item;
+        std::priority_queue<item,std::vector<item>,std::greater<item> > heap;
+        for(int i=0; i<(int)s.nodes.size(); i++)
+        {
+            int v = s.nodes[i];
+            unsigned int best = INF;
+            for(const int *it=graph.begin(v); it!=graph.end(v); it++)
+            {
+                unsigned int du = dist.get(*it,dest);
+                if(!s.in_subtree[*it] && du != INF && du + 1 < best)
+                    best = du + 1;
+            }
+            dist.set(v,dest,best == INF ? -1 : (int)best);
+            if(best != INF)
+                heap.push(item(best,v));
+        }
+        while(!heap.empty())
+        {
+            item top = heap.top();
+            heap.pop();
+            if(top.first != dist.get(top.second,dest))
+                continue;
+            for(const int *it=graph.begin(top.second); it!=graph.end(top.second); it++)
+            {
+                if(s.in_subtree[*it] && top.first + 1 < dist.get(*it,dest))
+                {
+                    dist.set(*it,dest,top.first + 1);
+                    heap.push(item(top.first + 1,*it));
+                }
+            }
+        }
+
+        long long changed = relink(s,dest);
+        for(int i=0; i<(int)s.nodes.size(); i++)
+            s.in_subtree[s.nodes[i]] = 0;
+        return changed;
+    }
+
+    int n;
+    std::vector<int> nodeA;
+    std::vector<int> nodeB;
+    csr_graph graph;
+    routing_matrix *table;
+    routing_matrix dist;
+    thread_pool *pool;
+    std::vector<repair_scratch> scratch;
+};
+
+#endif
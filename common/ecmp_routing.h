@@ -0,0 +1,144 @@
+#ifndef COMMON_ECMP_ROUTING_H
+#define COMMON_ECMP_ROUTING_H
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <climits>
+#include "graph.h"
+#include "bfs.h"
+#include "router.h"
+#include "routing_table.h"
+#include "thread_pool.h"
+
+// Routing tables with every equal-cost next hop
+// The next hops of node u toward dest are all neighbors one level closer to dest
+// A node meets few distinct next-hop sets, so each node keeps its own list of distinct
+// sets and the (node, dest) entry is the index of the set in that list
+// A flow picks one hop of the set by hashing its flowID with the node id, so one flow
+// always takes the same path while flows toward the same dest spread over the links
+class ecmp_router : public router
+{
+public:
+    ecmp_router(): n(0) {}
+
+    void build(const csr_graph &graph,thread_pool &pool)
+    {
+        n = graph.size();
+        choice.build(n);
+        std::vector<std::map<std::vector<int>,int>> known(n);
+        std::vector<std::vector<const std::vector<int>*>> sets(n);
+        std::vector<std::mutex> locks(LOCKS);
+
+        bfs_graph bgraph;
+        bgraph.build(graph);
+        std::vector<bfs_engine> engines(pool.size());
+        for(int i=0; i<pool.size(); i++)
+            engines[i].bind(bgraph);
+        pool.run(n,16,[&](int worker,int dest)
+        {
+            engines[worker].run(dest);
+            const int *level = engines[worker].levels();
+            std::vector<int> hops;
+            for(int u=0; u<n; u++)
+            {
+                if(u == dest || level[u] < 0)
+                    continue;
+                hops.clear();
+                for(const int *v=graph.begin(u); v!=graph.end(u); v++)
+                {
+                    // Parallel links give a hop once
+                    if(level[*v] == level[u] - 1 && std::find(hops.begin(),hops.end(),*v) == hops.end())
+                        hops.push_back(*v);
+                }
+                std::lock_guard<std::mutex> lock(locks[u % LOCKS]);
+                auto found = known[u].emplace(hops,(int)sets[u].size());
+                if(found.second)
+                    sets[u].push_back(&found.first->first);
+                choice.set(u,dest,found.first->second);
+            }
+        });
+
+        // Lay the sets of every node out one after another
+        first_set.assign(n + 1,0);
+        set_begin.clear();
+        hop.clear();
+        for(int u=0; u<n; u++)
+        {
+            first_set[u] = (int)set_begin.size();
+            for(size_t k=0; k<sets[u].size(); k++)
+            {
+                set_begin.push_back(hop.size());
+                hop.insert(hop.end(),sets[u][k]->begin(),sets[u][k]->end());
+            }
+        }
+        first_set[n] = (int)set_begin.size();
+        set_begin.push_back(hop.size());
+        return;
+    }
+
+    // The first of the equal-cost hops
+    unsigned int next_hop(int node,int dest)
+    {
+        size_t begin,count;
+        if(!hops_of(node,dest,begin,count))
+            return (node == dest) ? dest : UINT_MAX;
+        return hop[begin];
+    }
+
+    unsigned int flow_hop(int node,int dest,unsigned int flow)
+    {
+        size_t begin,count;
+        if(!hops_of(node,dest,begin,count))
+            return (node == dest) ? dest : UINT_MAX;
+        return (count == 1) ? hop[begin] : hop[begin + mix(flow,node) % count];
+    }
+
+    size_t bytes() const
+    {
+        return choice.bytes() + first_set.size() * sizeof(int) +
+               set_begin.size() * sizeof(size_t) + hop.size() * sizeof(int);
+    }
+    // Distinct next-hop sets over all nodes
+    size_t set_count() const
+    {
+        return set_begin.size() - 1;
+    }
+
+private:
+    static const int LOCKS = 64;
+
+    // Range of hop holding the next hops from node toward dest
+    bool hops_of(int node,int dest,size_t &begin,size_t &count) const
+    {
+        if(node == dest)
+            return false;
+        unsigned int k = choice.get(node,dest);
+        if(k == routing_matrix::NONE)
+            return false;
+        begin = set_begin[first_set[node] + k];
+        count = set_begin[first_set[node] + k + 1] - begin;
+        return true;
+    }
+
+    // Hash of (flow, node), so the choices at successive nodes are independent
+    static unsigned int mix(unsigned int flow,int node)
+    {
+        unsigned int h = flow * 0x9E3779B1u ^ (unsigned int)node * 0x85EBCA77u;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    int n;
+    routing_matrix choice;          // (node, dest) -> index of the set among node's sets
+    std::vector<int> first_set;     // node -> its first set
+    std::vector<size_t> set_begin;  // set -> its first hop
+    std::vector<int> hop;
+};
+
+#endif
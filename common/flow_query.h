@@ -0,0 +1,72 @@
+#ifndef COMMON_FLOW_QUERY_H
+#define COMMON_FLOW_QUERY_H
+
+#include <vector>
+#include <algorithm>
+#include "thread_pool.h"
+#include "output_writer.h"
+
+// Answer a batch of flows on the pool and print the answers in input order
+// flows holds (flowID, source, dest) triples; next(node, dest, flowID) is the routing table lookup
+// Every answer is "flowID source ... dest", or "flowID hops" when hops_only is set
+// Flows are cut into chunks which the workers format into their own buffers;
+// a round of buffers is written out in order before the next round starts
+// hops(source, dest, flowID) gives the hop count when the backend knows it without walking the path
+template<class NextHop,class HopCount>
+void answer_flows(const int *flows,int count,bool hops_only,thread_pool &pool,output_writer &out,NextHop next,HopCount hops)
+{
+    const int CHUNK = 4096;
+    int chunks = (count + CHUNK - 1) / CHUNK;
+    int round = pool.size() * 4;
+    std::vector<text_buffer> buffers(round);
+
+    for(int first=0; first<chunks; first+=round)
+    {
+        int todo = std::min(round,chunks - first);
+        pool.run(todo,1,[&](int,int c)
+        {
+            text_buffer &buf = buffers[c];
+            buf.clear();
+            int begin = (first + c) * CHUNK;
+            int end = std::min(count,begin + CHUNK);
+            for(int i=begin; i<end; i++)
+            {
+                int flowID = flows[3*i],source = flows[3*i+1],dest = flows[3*i+2];
+                buf << flowID << " ";
+                if(hops_only)
+                    buf << hops(source,dest,flowID) << "\n";
+                else
+                {
+                    while(source != dest)
+                    {
+                        buf << source << " ";
+                        source = next(source,dest,flowID);
+                    }
+                    buf << dest << "\n";
+                }
+            }
+        });
+        for(int c=0; c<todo; c++)
+            out << buffers[c];
+    }
+    return;
+}
+
+// Hop counts found by walking the path with next
+template<class NextHop>
+void answer_flows(const int *flows,int count,bool hops_only,thread_pool &pool,output_writer &out,NextHop next)
+{
+    answer_flows(flows,count,hops_only,pool,out,next,[&](int source,int dest,int flowID)
+    {
+        int hops = 0;
+        while(source != dest)
+        {
+            source = next(source,dest,flowID);
+            hops++;
+        }
+        return hops;
+    });
+    return;
+}
+
+#endif
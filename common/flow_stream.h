@@ -0,0 +1,57 @@
+#ifndef COMMON_FLOW_STREAM_H
+#define COMMON_FLOW_STREAM_H
+
+#include <chrono>
+#include "input_reader.h"
+#include "output_writer.h"
+#include "latency_histogram.h"
+
+// Answer flows as they arrive, one "flowID source dest" per line, until the input ends
+// Lines with another number of integers (e.g. a flow count) are skipped
+// Answers are flushed as soon as no more input is waiting, or after FLUSH_EVERY answers,
+// so a burst is written in few system calls while a single request is answered at once
+// The latency of a flow runs from its line being read to its answer being flushed
+// next(node, dest, flowID) is the routing table lookup; n bounds the node ids
+template<class NextHop>
+void stream_flows(input_reader &in,output_writer &out,int n,latency_histogram &latency,NextHop next)
+{
+    typedef std::chrono::steady_clock clock;
+    const int FLUSH_EVERY = 64;
+    clock::time_point waiting[FLUSH_EVERY];
+    int unflushed = 0;
+    int values[3],count;
+    while(in.read_line(values,3,count))
+    {
+        if(count != 3)
+            continue;
+        waiting[unflushed++] = clock::now();
+        int flowID = values[0],source = values[1],dest = values[2];
+        out << flowID << " ";
+        if(source < 0 || source >= n || dest < 0 || dest >= n)
+            out << "invalid\n";
+        else
+        {
+            while(source != dest)
+            {
+                out << source << " ";
+                source = next(source,dest,flowID);
+            }
+            out << dest << "\n";
+        }
+        if(unflushed == FLUSH_EVERY || !in.buffered())
+        {
+            out.flush();
+            clock::time_point now = clock::now();
+            for(int i=0; i<unflushed; i++)
+                latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - waiting[i]).count());
+            unflushed = 0;
+        }
+    }
+    out.flush();
+    clock::time_point now = clock::now();
+    for(int i=0; i<unflushed; i++)
+        latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - waiting[i]).count());
+    return;
+}
+
+#endif
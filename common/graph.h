@@ -0,0 +1,183 @@
+#ifndef COMMON_GRAPH_H
+#define COMMON_GRAPH_H
+
+#include <vector>
+#include <cstdint>
+
+// Compressed sparse row graph
+// The neighbors of node v are adj[offset[v]] ... adj[offset[v+1]-1],
+// kept in the same order as the links were read
+// The arrays are either owned by the graph or viewed in memory owned by someone else
+class csr_graph
+{
+public:
+    csr_graph(): n(0), off(nullptr), nb(nullptr)
+    {
+        offset.assign(1,0);
+        own();
+    }
+
+    // The first link with an end outside 0 .. n-1, -1 if there is none
+    // build trusts its input, so check links read from a file with this first
+    static int bad_link(int n,const std::vector<int> &nodeA,const std::vector<int> &nodeB)
+    {
+        for(int i=0; i<(int)nodeA.size(); i++)
+        {
+            if(nodeA[i] < 0 || nodeA[i] >= n || nodeB[i] < 0 || nodeB[i] >= n)
+                return i;
+        }
+        return -1;
+    }
+
+    // Build an undirected graph from the link list
+    // Count the degrees first, then drop every link into its two slots
+    void build(int _n,const std::vector<int> &nodeA,const std::vector<int> &nodeB)
+    {
+        n = _n;
+        offset.assign(n+1,0);
+        for(int i=0; i<(int)nodeA.size(); i++)
+        {
+            offset[nodeA[i]+1]++;
+            offset[nodeB[i]+1]++;
+        }
+        for(int i=0; i<n; i++)
+            offset[i+1] += offset[i];
+
+        adj.resize(offset[n]);
+        std::vector<int> fill(offset.begin(),offset.end()-1);
+        for(int i=0; i<(int)nodeA.size(); i++)
+        {
+            adj[fill[nodeA[i]]++] = nodeB[i];
+            adj[fill[nodeB[i]]++] = nodeA[i];
+        }
+        own();
+        return;
+    }
+    // Spread one value per link over the two slots build gave the link,
+    // e.g. link weights for a weighted search; the graph must be built from the same links
+    void slot_values(const std::vector<int> &nodeA,const std::vector<int> &nodeB,
+                     const std::vector<int> &value,std::vector<int> &slot) const
+    {
+        slot.resize(edges());
+        std::vector<int> fill(off,off+n);
+        for(int i=0; i<(int)nodeA.size(); i++)
+        {
+            slot[fill[nodeA[i]]++] = value[i];
+            slot[fill[nodeB[i]]++] = value[i];
+        }
+        return;
+    }
+    // Take over arrays which are already in CSR form
+    void assign(int _n,std::vector<int> &_offset,std::vector<int> &_adj)
+    {
+        n = _n;
+        offset.swap(_offset);
+        adj.swap(_adj);
+        own();
+        return;
+    }
+    // Use arrays in CSR form without copying them, e.g. from a mapped file
+    // They must stay alive as long as the graph is used
+    void view(int _n,const int *_offset,const int *_adj)
+    {
+        n = _n;
+        offset.clear();
+        adj.clear();
+        off = _offset;
+        nb = _adj;
+        return;
+    }
+
+    int size() const
+    {
+        return n;
+    }
+    int edges() const
+    {
+        return off[n];
+    }
+    int degree(int v) const
+    {
+        return off[v+1] - off[v];
+    }
+    const int *begin(int v) const
+    {
+        return nb + off[v];
+    }
+    const int *end(int v) const
+    {
+        return nb + off[v+1];
+    }
+    // Every link once as nodeA[i]-nodeB[i] with nodeA[i] < nodeB[i]
+    void link_list(std::vector<int> &nodeA,std::vector<int> &nodeB) const
+    {
+        nodeA.clear();
+        nodeB.clear();
+        for(int u=0; u<n; u++)
+        {
+            for(const int *it=begin(u); it!=end(u); it++)
+            {
+                if(u < *it)
+                {
+                    nodeA.push_back(u);
+                    nodeB.push_back(*it);
+                }
+            }
+        }
+        return;
+    }
+
+    const int *offsets() const
+    {
+        return off;
+    }
+    const int *neighbors() const
+    {
+        return nb;
+    }
+
+private:
+    csr_graph(const csr_graph &) = delete; // lock the copy constructor
+    csr_graph &operator=(const csr_graph &) = delete; // and the copy assignment
+    void own()
+    {
+        off = offset.data();
+        nb = adj.data();
+        return;
+    }
+
+    int n;
+    const int *off;
+    const int *nb;
+    std::vector<int> offset;
+    std::vector<int> adj;
+};
+
+// A subset of the nodes of a graph as a bitset
+// A search bound to a mask only enters the nodes inside it, which views the subgraph
+// without copying its links; the start node itself may lie outside
+class node_mask
+{
+public:
+    // Node v is inside when member[v] != 0
+    void build(int n,const int member[])
+    {
+        bits.assign((n+63)/64,0);
+        for(int v=0; v<n; v++)
+        {
+            if(member[v] != 0)
+                bits[v >> 6] |= (uint64_t)1 << (v & 63);
+        }
+        return;
+    }
+
+    bool contains(int v) const
+    {
+        return (bits[v >> 6] >> (v & 63)) & 1;
+    }
+
+private:
+    std::vector<uint64_t> bits;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef COMMON_INPUT_READER_H
+#define COMMON_INPUT_READER_H
+
+#include <cstdio>
+#include <cstddef>
+#include <climits>
+#include <vector>
+#include "mapped_file.h"
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Fast reader for the whitespace separated unsigned integers of the text inputs
+// long long reads keep a leading minus sign, for the values that may be negative, e.g. link weights
+// A regular file on stdin is memory-mapped; pipes and terminals are read in large blocks
+// Used like cin: in >> n >> links; the reader turns false after a read past the end,
+// and a value read past the end is 0, so callers check the reader before trusting it
+class input_reader
+{
+public:
+    static const size_t BLOCK = 1 << 20;
+
+    input_reader(int _fd = 0): fd(_fd), pos(nullptr), last(nullptr), good(true)
+    {
+#ifndef _WIN32
+        if(file.open_fd(fd) && file.size() > 0)
+        {
+            pos = file.begin();
+            last = pos + file.size();
+            fd = -1; // everything is mapped, nothing left to read
+        }
+#endif
+    }
+
+    input_reader &operator>>(unsigned int &x)
+    {
+        int c = get();
+        while(c != -1 && (c < '0' || c > '9'))
+            c = get();
+        if(c == -1)
+        {
+            good = false;
+            x = 0;
+            return *this;
+        }
+        unsigned int value = 0;
+        while(c >= '0' && c <= '9')
+        {
+            value = value * 10 + (c - '0');
+            c = get();
+        }
+        x = value;
+        return *this;
+    }
+    input_reader &operator>>(int &x)
+    {
+        unsigned int value;
+        *this >> value;
+        x = (int)value;
+        return *this;
+    }
+    // A value beyond the range of long long reads as LLONG_MAX or -LLONG_MAX
+    input_reader &operator>>(long long &x)
+    {
+        int c = get();
+        while(c != -1 && c != '-' && (c < '0' || c > '9'))
+            c = get();
+        bool negative = (c == '-');
+        if(negative)
+            c = get();
+        if(c == -1)
+        {
+            good = false;
+            x = 0;
+            return *this;
+        }
+        unsigned long long value = 0;
+        while(c >= '0' && c <= '9')
+        {
+            unsigned long long digit = c - '0';
+            value = (value > (LLONG_MAX - digit) / 10) ? LLONG_MAX : value * 10 + digit;
+            c = get();
+        }
+        x = negative ? -(long long)value : (long long)value;
+        return *this;
+    }
+
+    // Read the integers of the next non-empty line, at most max of them are kept
+    // Returns false at the end of the input; count is how many integers the line had
+    // Only reads past the line's newline when the line is not complete, so a pipe can
+    // be answered line by line
+    bool read_line(int values[],int max,int &count)
+    {
+        count = 0;
+        int c = get();
+        while(true)
+        {
+            if(c == -1)
+            {
+                good = false;
+                return count > 0;
+            }
+            if(c == '\n' && count > 0)
+                return true;
+            if(c < '0' || c > '9')
+            {
+                c = get();
+                continue;
+            }
+            unsigned int value = 0;
+            while(c >= '0' && c <= '9')
+            {
+                value = value * 10 + (c - '0');
+                c = get();
+            }
+            if(count < max)
+                values[count] = (int)value;
+            count++;
+        }
+    }
+    // Whether input is already buffered, i.e. the next read will not wait
+    bool buffered() const
+    {
+        return pos != last;
+    }
+
+    explicit operator bool() const
+    {
+        return good;
+    }
+
+private:
+    input_reader(const input_reader &) = delete; // lock the copy constructor
+    input_reader &operator=(const input_reader &) = delete; // and the copy assignment
+
+    int get()
+    {
+        if(pos == last && !refill())
+            return -1;
+        return (unsigned char)*pos++;
+    }
+    bool refill()
+    {
+        if(fd < 0)
+            return false;
+        if(buffer.empty())
+            buffer.resize(BLOCK);
+#ifndef _WIN32
+        ssize_t got = ::read(fd,buffer.data(),buffer.size());
+#else
+        long long got = fread(buffer.data(),1,buffer.size(),stdin);
+#endif
+        if(got <= 0)
+        {
+            fd = -1;
+            return false;
+        }
+        pos = buffer.data();
+        last = pos + got;
+        return true;
+    }
+
+    int fd;
+    const char *pos;
+    const char *last;
+    bool good;
+    mapped_file file;
+    std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef COMMON_LANDMARK_LABELS_H
+#define COMMON_LANDMARK_LABELS_H
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "graph.h"
+#include "router.h"
+
+// Hop distance oracle from pruned landmark labeling (2-hop cover)
+// Every node keeps a label of (hub, distance) pairs such that for every pair s, t some
+// hub on a shortest s-t path is in both labels; distance(s, t) is a merge of two labels
+// Hubs are taken in decreasing degree order and each hub's BFS stops at nodes whose
+// distance is already covered by earlier hubs, which keeps the labels small
+// A next hop is the first neighbor one hop closer to dest, so paths are shortest but
+// ties can go another way than in build_routing_table
+class landmark_oracle : public router
+{
+public:
+    landmark_oracle(): n(0), graph(nullptr) {}
+
+    void build(const csr_graph &_graph)
+    {
+        graph = &_graph;
+        n = graph->size();
+        // Rank nodes by degree, highest first
+        std::vector<int> order(n);
+        for(int i=0; i<n; i++)
+            order[i] = i;
+        std::stable_sort(order.begin(),order.end(),[&](int a,int b)
+        {
+            return graph->degree(a) > graph->degree(b);
+        });
+
+        std::vector<std::vector<int>> hubs(n),dists(n);
+        std::vector<int> root_dist(n + 1,INF);
+        std::vector<int> level(n,-1);
+        std::vector<int> queue(n);
+        for(int rank=0; rank<n; rank++)
+        {
+            int root = order[rank];
+            for(size_t k=0; k<hubs[root].size(); k++)
+                root_dist[hubs[root][k]] = dists[root][k];
+            // Pruned BFS from root
+            int head = 0,tail = 0;
+            queue[tail++] = root;
+            level[root] = 0;
+            while(head < tail)
+            {
+                int u = queue[head++];
+                int d = level[u];
+                bool covered = false;
+                for(size_t k=0; k<hubs[u].size(); k++)
+                {
+                    if(root_dist[hubs[u][k]] != INF && root_dist[hubs[u][k]] + dists[u][k] <= d)
+                    {
+                        covered = true;
+                        break;
+                    }
+                }
+                if(covered)
+                    continue;
+                hubs[u].push_back(rank);
+                dists[u].push_back(d);
+                for(const int *v=graph->begin(u); v!=graph->end(u); v++)
+                {
+                    if(level[*v] < 0)
+                    {
+                        level[*v] = d + 1;
+                        queue[tail++] = *v;
+                    }
+                }
+            }
+            for(int i=0; i<tail; i++)
+                level[queue[i]] = -1;
+            for(size_t k=0; k<hubs[root].size(); k++)
+                root_dist[hubs[root][k]] = INF;
+        }
+
+        // Flatten the labels, each closed by a sentinel hub n
+        label_begin.assign(n + 1,0);
+        hub.clear();
+        dist.clear();
+        for(int i=0; i<n; i++)
+        {
+            label_begin[i] = hub.size();
+            hub.insert(hub.end(),hubs[i].begin(),hubs[i].end());
+            dist.insert(dist.end(),dists[i].begin(),dists[i].end());
+            hub.push_back(n);
+            dist.push_back(0);
+            std::vector<int>().swap(hubs[i]);
+            std::vector<int>().swap(dists[i]);
+        }
+        label_begin[n] = hub.size();
+        return;
+    }
+
+    // Hop count of a shortest path from s to t, -1 if t cannot be reached
+    int distance(int s,int t) const
+    {
+        if(s == t)
+            return 0;
+        const int *hs = &hub[label_begin[s]],*ds = &dist[label_begin[s]];
+        const int *ht = &hub[label_begin[t]],*dt = &dist[label_begin[t]];
+        int best = INF;
+        while(true)
+        {
+            if(*hs == *ht)
+            {
+                if(*hs == n)
+                    break;
+                best = std::min(best,*ds + *dt);
+                hs++, ds++, ht++, dt++;
+            }
+            else if(*hs < *ht)
+                hs++, ds++;
+            else
+                ht++, dt++;
+        }
+        return (best == INF) ? -1 : best;
+    }
+
+    unsigned int next_hop(int node,int dest)
+    {
+        if(node == dest)
+            return dest;
+        int d = distance(node,dest);
+        if(d < 0)
+            return UINT_MAX;
+        for(const int *v=graph->begin(node); v!=graph->end(node); v++)
+        {
+            if(distance(*v,dest) == d - 1)
+                return *v;
+        }
+        return UINT_MAX;
+    }
+
+    size_t bytes() const
+    {
+        return (hub.size() + dist.size()) * sizeof(int) + label_begin.size() * sizeof(size_t);
+    }
+    // Label entries without the sentinels
+    size_t entries() const
+    {
+        return hub.size() - n;
+    }
+
+private:
+    static constexpr int INF = INT_MAX / 2;
+
+    int n;
+    const csr_graph *graph;
+    std::vector<size_t> label_begin;
+    std::vector<int> hub;  // hub rank of every label entry, ascending within a label
+    std::vector<int> dist; // distance to that hub
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef COMMON_LATENCY_HISTOGRAM_H
+#define COMMON_LATENCY_HISTOGRAM_H
+
+#include <ostream>
+#include <cstring>
+
+// Fixed-size log-linear histogram of latencies in nanoseconds
+// Every power of two is cut into SUB buckets, so a percentile is off by at most 1/SUB
+// Recording never allocates
+class latency_histogram
+{
+public:
+    static const int SUB = 32;   // buckets per power of two
+    static const int POWERS = 40; // up to 2^40 ns, about 18 minutes
+
+    latency_histogram(): total(0), largest(0)
+    {
+        memset(count,0,sizeof(count));
+    }
+
+    void add(long long ns)
+    {
+        if(ns < 0)
+            ns = 0;
+        count[bucket(ns)]++;
+        total++;
+        if(ns > largest)
+            largest = ns;
+        return;
+    }
+
+    long long size() const
+    {
+        return total;
+    }
+    // Upper bound of the bucket holding the p-th percentile
+    long long percentile(double p) const
+    {
+        long long rank = (long long)(p / 100.0 * total + 0.5);
+        if(rank < 1)
+            rank = 1;
+        long long seen = 0;
+        for(int b=0; b<SUB*POWERS; b++)
+        {
+            seen += count[b];
+            if(seen >= rank)
+                return upper(b) < largest ? upper(b) : largest;
+        }
+        return largest;
+    }
+
+    // "p50 ... p99.9 ... max ..." in microseconds
+    void print(std::ostream &os) const
+    {
+        const double ps[] = {50,90,99,99.9};
+        const char *names[] = {"p50","p90","p99","p99.9"};
+        for(int i=0; i<4; i++)
+            os << names[i] << " " << percentile(ps[i]) / 1000.0 << " us, ";
+        os << "max " << largest / 1000.0 << " us";
+        return;
+    }
+
+private:
+    // Values below SUB get a bucket each, above that SUB buckets per power of two
+    static int bucket(long long ns)
+    {
+        if(ns < SUB)
+            return (int)ns;
+        int power = 5;
+        while((ns >> (power + 1)) != 0)
+            power++;
+        int shift = power - 5; // SUB = 2^5
+        int b = (power - 4) * SUB + (int)((ns >> shift) - SUB);
+        return b < SUB*POWERS ? b : SUB*POWERS - 1;
+    }
+    static long long upper(int b)
+    {
+        if(b < SUB)
+            return b;
+        int power = b / SUB + 4;
+        int shift = power - 5;
+        return ((long long)(b % SUB + SUB + 1) << shift) - 1;
+    }
+
+    long long count[SUB*POWERS];
+    long long total;
+    long long largest;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef COMMON_LAZY_ROUTING_H
+#define COMMON_LAZY_ROUTING_H
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include "graph.h"
+#include "bfs.h"
+#include "router.h"
+#include "routing_table.h"
+
+// Routes computed on demand, one destination at a time
+// The first lookup toward an unseen destination runs the BFS rooted at it and keeps
+// every node's next hop toward it as one cached column
+// Columns live in a fixed number of slots chosen from a byte budget; when all slots are
+// in use the least recently used column is evicted
+// The lock only guards the cache: a miss runs its BFS unlocked on an engine of its own and
+// installs the column afterwards, so lookups from other threads go on meanwhile (two threads
+// missing the same destination at once both search it, and the later result is dropped)
+// Paths are the same as build_routing_table's: the same BFS builds every column
+class lazy_router : public router
+{
+public:
+    lazy_router(): hits(0), misses(0), evictions(0), n(0), head(-1), tail(-1), used(0) {}
+
+    // The budget must hold at least one column, column_bytes(graph.size()); false if it does not
+    bool build(const csr_graph &graph,size_t budget)
+    {
+        n = graph.size();
+        size_t column = column_bytes(n);
+        if(budget < column)
+            return false;
+        bgraph.build(graph);
+        spare.clear();
+        int slots = (int)std::min((size_t)std::max(n,1),budget / column);
+        columns.build(n,slots);
+        slot_of.assign(n,-1);
+        dest_of.assign(slots,-1);
+        prev.assign(slots,-1);
+        next.assign(slots,-1);
+        head = tail = -1;
+        used = 0;
+        return true;
+    }
+
+    static size_t column_bytes(int n)
+    {
+        return std::max((size_t)1,(size_t)n * routing_matrix::entry_width(n));
+    }
+
+    unsigned int next_hop(int node,int dest)
+    {
+        if(node == dest)
+            return dest;
+        std::unique_lock<std::mutex> lock(guard);
+        int slot = slot_of[dest];
+        if(slot >= 0)
+        {
+            hits++;
+            unlink(slot);
+            push_front(slot);
+            return columns.get(slot,node);
+        }
+        misses++;
+        std::unique_ptr<bfs_engine> engine = take_engine();
+        lock.unlock();
+        engine->run(dest);
+        lock.lock();
+        // Another thread may have installed dest while this one searched
+        slot = slot_of[dest];
+        if(slot >= 0)
+            unlink(slot);
+        else
+            slot = fill(dest,engine->parents());
+        push_front(slot);
+        spare.push_back(std::move(engine));
+        return columns.get(slot,node);
+    }
+
+    int slots() const
+    {
+        return columns.row_count();
+    }
+    size_t bytes() const
+    {
+        return columns.bytes();
+    }
+
+    long long hits;
+    long long misses;
+    long long evictions;
+
+private:
+    // An idle engine, or a new one when every engine is searching; called under the lock
+    std::unique_ptr<bfs_engine> take_engine()
+    {
+        if(spare.empty())
+        {
+            std::unique_ptr<bfs_engine> engine(new bfs_engine());
+            engine->bind(bgraph);
+            return engine;
+        }
+        std::unique_ptr<bfs_engine> engine = std::move(spare.back());
+        spare.pop_back();
+        return engine;
+    }
+
+    // Store dest's column into a free slot, or into the least recently used one
+    int fill(int dest,const int *last_node)
+    {
+        int slot;
+        if(used < columns.row_count())
+            slot = used++;
+        else
+        {
+            slot = tail;
+            unlink(slot);
+            slot_of[dest_of[slot]] = -1;
+            evictions++;
+        }
+        for(int i=0; i<n; i++)
+            columns.set(slot,i,last_node[i]);
+        slot_of[dest] = slot;
+        dest_of[slot] = dest;
+        return slot;
+    }
+
+    // Most recently used slot at head
+    void unlink(int slot)
+    {
+        if(prev[slot] >= 0)
+            next[prev[slot]] = next[slot];
+        else
+            head = next[slot];
+        if(next[slot] >= 0)
+            prev[next[slot]] = prev[slot];
+        else
+            tail = prev[slot];
+        prev[slot] = next[slot] = -1;
+        return;
+    }
+    void push_front(int slot)
+    {
+        prev[slot] = -1;
+        next[slot] = head;
+        if(head >= 0)
+            prev[head] = slot;
+        head = slot;
+        if(tail < 0)
+            tail = slot;
+        return;
+    }
+
+    int n;
+    bfs_graph bgraph;
+    std::vector<std::unique_ptr<bfs_engine>> spare; // engines not searching right now
+    routing_matrix columns; // row s is the column of dest_of[s]
+    std::vector<int> slot_of;
+    std::vector<int> dest_of;
+    std::vector<int> prev;
+    std::vector<int> next;
+    int head;
+    int tail;
+    int used;
+    std::mutex guard;
+};
+
+#endif
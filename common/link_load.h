@@ -0,0 +1,72 @@
+#ifndef COMMON_LINK_LOAD_H
+#define COMMON_LINK_LOAD_H
+
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include "graph.h"
+
+// Number of flows crossing every directed link
+// Counts live in the graph's edge slots: slot k of node u is the link u -> neighbor k
+class link_load
+{
+public:
+    link_load(): graph(nullptr) {}
+
+    void build(const csr_graph &_graph)
+    {
+        graph = &_graph;
+        load.assign(graph->edges(),0);
+        return;
+    }
+
+    // Count one flow on the link u -> v
+    void add(int u,int v)
+    {
+        const int *slot = std::find(graph->begin(u),graph->end(u),v);
+        if(slot != graph->end(u))
+            load[slot - graph->neighbors()]++;
+        return;
+    }
+
+    // Busiest link, mean load and a histogram of the loads in power-of-two buckets
+    void print(std::ostream &os) const
+    {
+        long long most = 0,total = 0;
+        for(size_t i=0; i<load.size(); i++)
+        {
+            most = std::max(most,load[i]);
+            total += load[i];
+        }
+        os << "link load: " << load.size() << " directed links, max " << most << ", mean "
+           << (load.empty() ? 0.0 : (double)total / load.size()) << "\n";
+        // Bucket 0 holds idle links, bucket b holds loads in [2^(b-1), 2^b)
+        std::vector<long long> buckets;
+        for(size_t i=0; i<load.size(); i++)
+        {
+            size_t b = 0;
+            while(b < 63 && (load[i] >> b) != 0)
+                b++;
+            if(buckets.size() <= b)
+                buckets.resize(b + 1,0);
+            buckets[b]++;
+        }
+        for(size_t b=0; b<buckets.size(); b++)
+        {
+            if(b == 0)
+                os << "  0: ";
+            else if(b == 1)
+                os << "  1: ";
+            else
+                os << "  " << (1LL << (b-1)) << "-" << (1LL << b) - 1 << ": ";
+            os << buckets[b] << "\n";
+        }
+        return;
+    }
+
+private:
+    const csr_graph *graph;
+    std::vector<long long> load;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef COMMON_LUBY_MIS_H
+#define COMMON_LUBY_MIS_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include "graph.h"
+#include "thread_pool.h"
+
+// Maximal independent set in rounds of local minima (Luby)
+// Every node gets a pseudo-random priority from the seed; in a round every undecided node
+// whose priority beats all of its undecided neighbors joins the set, then it and its
+// neighbors are decided. Equal priorities go to the lower id
+// A round is two passes over the undecided bitset on the thread pool, one 64-node word per job:
+// the first only reads the bits, the second clears them with atomic ands
+// The set depends on the seed only, never on the number of threads
+class luby_mis
+{
+public:
+    static const int CHUNK = 16; // words per pool chunk
+
+    luby_mis(): rounds(0), n(0), words(0) {}
+
+    // Set MIS[v] = 1 for the nodes in the set; the other entries are left alone
+    void build(const csr_graph &graph,uint64_t seed,thread_pool &pool,int MIS[])
+    {
+        n = graph.size();
+        words = (n + 63) / 64;
+        priority.resize(n);
+        chosen.assign(words,0);
+        undecided.reset(new std::atomic<uint64_t>[words]);
+        pool.run(words,CHUNK,[&](int,int k)
+        {
+            int last = std::min(n,k * 64 + 64);
+            uint64_t bits = (last - k * 64 == 64) ? ~0ULL : (1ULL << (last - k * 64)) - 1;
+            undecided[k].store(bits,std::memory_order_relaxed);
+            for(int v=k*64; v<last; v++)
+                priority[v] = mix(seed,v);
+        });
+
+        rounds = 0;
+        while(left() > 0)
+        {
+            rounds++;
+            // The local minima join the set
+            pool.run(words,CHUNK,[&](int,int k)
+            {
+                uint64_t todo = undecided[k].load(std::memory_order_relaxed),pick = 0;
+                while(todo != 0)
+                {
+                    int b = __builtin_ctzll(todo);
+                    todo &= todo - 1;
+                    if(local_minimum(graph,k * 64 + b))
+                        pick |= 1ULL << b;
+                }
+                chosen[k] = pick;
+            });
+            // They and their neighbors are decided
+            pool.run(words,CHUNK,[&](int,int k)
+            {
+                uint64_t pick = chosen[k];
+                if(pick == 0)
+                    return;
+                undecided[k].fetch_and(~pick,std::memory_order_relaxed);
+                while(pick != 0)
+                {
+                    int v = k * 64 + __builtin_ctzll(pick);
+                    pick &= pick - 1;
+                    MIS[v] = 1;
+                    for(const int *it=graph.begin(v); it!=graph.end(v); it++)
+                        undecided[*it >> 6].fetch_and(~(1ULL << (*it & 63)),std::memory_order_relaxed);
+                }
+            });
+        }
+        return;
+    }
+
+    int rounds;
+
+private:
+    luby_mis(const luby_mis &) = delete; // lock the copy constructor
+    luby_mis &operator=(const luby_mis &) = delete; // and the copy assignment
+
+    bool is_undecided(int v) const
+    {
+        return (undecided[v >> 6].load(std::memory_order_relaxed) >> (v & 63)) & 1;
+    }
+    // v comes before u
+    bool beats(int v,int u) const
+    {
+        return priority[v] < priority[u] || (priority[v] == priority[u] && v < u);
+    }
+    bool local_minimum(const csr_graph &graph,int v) const
+    {
+        for(const int *it=graph.begin(v); it!=graph.end(v); it++)
+        {
+            if(*it != v && is_undecided(*it) && !beats(v,*it))
+                return false;
+        }
+        return true;
+    }
+
+    long long left() const
+    {
+        long long count = 0;
+        for(int k=0; k<words; k++)
+            count += __builtin_popcountll(undecided[k].load(std::memory_order_relaxed));
+        return count;
+    }
+
+    // splitmix64 of (seed, node)
+    static uint32_t mix(uint64_t seed,int v)
+    {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL * ((uint64_t)v + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (uint32_t)((z ^ (z >> 31)) >> 32);
+    }
+
+    int n;
+    int words;
+    std::vector<uint32_t> priority;
+    std::vector<uint64_t> chosen;                     // the nodes joining in this round
+    std::unique_ptr<std::atomic<uint64_t>[]> undecided;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef COMMON_MAPPED_FILE_H
+#define COMMON_MAPPED_FILE_H
+
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// A read-only view of a whole file
+// The file is memory-mapped where mmap exists, otherwise it is read into a buffer
+class mapped_file
+{
+public:
+    mapped_file(): data(nullptr), length(0), mapped(false) {}
+    ~mapped_file()
+    {
+        close();
+    }
+
+    bool open(const char *path)
+    {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path,O_RDONLY);
+        if(fd < 0)
+            return false;
+        bool ok = open_fd(fd);
+        ::close(fd);
+        return ok;
+#else
+        FILE *f = fopen(path,"rb");
+        if(f == nullptr)
+            return false;
+        char chunk[1 << 16];
+        size_t got;
+        while((got = fread(chunk,1,sizeof(chunk),f)) > 0)
+            buffer.insert(buffer.end(),chunk,chunk + got);
+        fclose(f);
+        data = buffer.data();
+        length = buffer.size();
+        return true;
+#endif
+    }
+#ifndef _WIN32
+    // Map an open regular file; fails for pipes and terminals
+    bool open_fd(int fd)
+    {
+        close();
+        struct stat st;
+        if(fstat(fd,&st) != 0 || !S_ISREG(st.st_mode))
+            return false;
+        length = st.st_size;
+        if(length == 0)
+            return true;
+        void *p = mmap(nullptr,length,PROT_READ,MAP_PRIVATE,fd,0);
+        if(p == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+        data = (const char *)p;
+        mapped = true;
+        return true;
+    }
+#endif
+    void close()
+    {
+#ifndef _WIN32
+        if(mapped)
+            munmap((void *)data,length);
+#endif
+        buffer.clear();
+        data = nullptr;
+        length = 0;
+        mapped = false;
+        return;
+    }
+
+    const char *begin() const
+    {
+        return data;
+    }
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    mapped_file(const mapped_file &) = delete; // lock the copy constructor
+    mapped_file &operator=(const mapped_file &) = delete; // and the copy assignment
+    const char *data;
+    size_t length;
+    bool mapped;
+    std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef COMMON_MS_BFS_H
+#define COMMON_MS_BFS_H
+
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Number of 64-bit words per lane mask
+// With AVX2 one mask is a 256-bit register, so every pass runs 256 searches
+#ifdef __AVX2__
+const int MS_BFS_WORDS = 4;
+#else
+const int MS_BFS_WORDS = 1;
+#endif
+
+// One bit per search
+struct lane_mask
+{
+    uint64_t w[MS_BFS_WORDS];
+
+    void clear()
+    {
+        for(int i=0; i<MS_BFS_WORDS; i++)
+            w[i] = 0;
+    }
+    bool any() const
+    {
+        uint64_t x = 0;
+        for(int i=0; i<MS_BFS_WORDS; i++)
+            x |= w[i];
+        return x != 0;
+    }
+};
+
+// Bit-parallel multi-source BFS (Then et al., "The More the Merrier")
+// Up to LANES searches share one sweep over the graph; every node keeps one bit per search
+// in seen (reached before), visit (in the frontier) and visit_next (reached in this step)
+// Frontier nodes are expanded in increasing id order, so in every search a node's parent
+// is its lowest-id neighbor on the previous level
+class ms_bfs_engine
+{
+public:
+    static const int LANES = 64 * MS_BFS_WORDS;
+
+    ms_bfs_engine(): g(nullptr), n(0) {}
+
+    void bind(const csr_graph &_g)
+    {
+        g = &_g;
+        n = g->size();
+        seen.resize(n);
+        visit.resize(n);
+        visit_next.resize(n);
+        return;
+    }
+
+    // Search from sources[0] ... sources[count-1], count <= LANES
+    // found(node, lane, parent) is called once for every node a search reaches, except its source
+    template<class F>
+    void run(const int *sources,int count,F found)
+    {
+        for(int v=0; v<n; v++)
+        {
+            seen[v].clear();
+            visit[v].clear();
+            visit_next[v].clear();
+        }
+        for(int s=0; s<count; s++)
+        {
+            seen[sources[s]].w[s >> 6] |= (uint64_t)1 << (s & 63);
+            visit[sources[s]].w[s >> 6] |= (uint64_t)1 << (s & 63);
+        }
+
+        bool active = count > 0;
+        while(active)
+        {
+            for(int v=0; v<n; v++)
+            {
+                if(!visit[v].any())
+                    continue;
+                for(const int *it=g->begin(v); it!=g->end(v); it++)
+                {
+                    int u = *it;
+                    for(int i=0; i<MS_BFS_WORDS; i++)
+                    {
+                        // Searches which reach u for the first time, through v
+                        uint64_t d = visit[v].w[i] & ~seen[u].w[i] & ~visit_next[u].w[i];
+                        if(d == 0)
+                            continue;
+                        visit_next[u].w[i] |= d;
+                        while(d)
+                        {
+                            found(u,i * 64 + __builtin_ctzll(d),v);
+                            d &= d - 1;
+                        }
+                    }
+                }
+            }
+            active = false;
+            for(int v=0; v<n; v++)
+            {
+                for(int i=0; i<MS_BFS_WORDS; i++)
+                {
+                    seen[v].w[i] |= visit_next[v].w[i];
+                    visit[v].w[i] = visit_next[v].w[i];
+                    visit_next[v].w[i] = 0;
+                }
+                active = active || visit[v].any();
+            }
+        }
+        return;
+    }
+
+private:
+    const csr_graph *g;
+    int n;
+    std::vector<lane_mask> seen;
+    std::vector<lane_mask> visit;
+    std::vector<lane_mask> visit_next;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef COMMON_OUTPUT_WRITER_H
+#define COMMON_OUTPUT_WRITER_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <algorithm>
+
+// A right-aligned number, the same as << setw(width) << value
+struct padded
+{
+    padded(unsigned int _value,int _width): value(_value), width(_width) {}
+    unsigned int value;
+    int width;
+};
+
+// Growing text buffer, used to format output away from stdout (e.g. on worker threads)
+class text_buffer
+{
+public:
+    text_buffer(): used(0) {}
+
+    text_buffer &operator<<(unsigned int x)
+    {
+        reserve(16);
+        used = std::to_chars(buffer.data() + used,buffer.data() + buffer.size(),x).ptr - buffer.data();
+        return *this;
+    }
+    text_buffer &operator<<(int x)
+    {
+        reserve(16);
+        used = std::to_chars(buffer.data() + used,buffer.data() + buffer.size(),x).ptr - buffer.data();
+        return *this;
+    }
+    text_buffer &operator<<(char c)
+    {
+        reserve(1);
+        buffer[used++] = c;
+        return *this;
+    }
+    text_buffer &operator<<(const char *s)
+    {
+        size_t len = strlen(s);
+        reserve(len);
+        memcpy(buffer.data() + used,s,len);
+        used += len;
+        return *this;
+    }
+
+    void clear()
+    {
+        used = 0;
+    }
+    const char *data() const
+    {
+        return buffer.data();
+    }
+    size_t size() const
+    {
+        return used;
+    }
+
+private:
+    void reserve(size_t len)
+    {
+        if(used + len > buffer.size())
+            buffer.resize(std::max(2 * buffer.size(),used + len + 256));
+    }
+
+    size_t used;
+    std::vector<char> buffer;
+};
+
+// Buffered writer for stdout
+// Integers are formatted with to_chars straight into a large buffer,
+// which goes to stdout in one fwrite when it fills up, on flush() and at destruction
+// Used like cout: out << flowID << " " << padded(time,11) << "\n";
+class output_writer
+{
+public:
+    static const size_t BLOCK = 1 << 20;
+
+    output_writer(FILE *_f = stdout): f(_f), used(0)
+    {
+        buffer.resize(BLOCK);
+    }
+    ~output_writer()
+    {
+        flush();
+    }
+
+    output_writer &operator<<(unsigned int x)
+    {
+        reserve(16);
+        used = std::to_chars(buffer.data() + used,buffer.data() + buffer.size(),x).ptr - buffer.data();
+        return *this;
+    }
+    output_writer &operator<<(int x)
+    {
+        reserve(16);
+        used = std::to_chars(buffer.data() + used,buffer.data() + buffer.size(),x).ptr - buffer.data();
+        return *this;
+    }
+    output_writer &operator<<(char c)
+    {
+        reserve(1);
+        buffer[used++] = c;
+        return *this;
+    }
+    output_writer &operator<<(const char *s)
+    {
+        return write(s,strlen(s));
+    }
+    output_writer &operator<<(const std::string &s)
+    {
+        return write(s.data(),s.size());
+    }
+    output_writer &operator<<(const padded &p)
+    {
+        char digits[16];
+        int len = std::to_chars(digits,digits + sizeof(digits),p.value).ptr - digits;
+        reserve(p.width + len);
+        for(int i=len; i<p.width; i++)
+            buffer[used++] = ' ';
+        memcpy(buffer.data() + used,digits,len);
+        used += len;
+        return *this;
+    }
+
+    output_writer &operator<<(const text_buffer &b)
+    {
+        return write(b.data(),b.size());
+    }
+
+    output_writer &write(const char *s,size_t len)
+    {
+        if(len > buffer.size())
+        {
+            flush();
+            fwrite(s,1,len,f);
+            return *this;
+        }
+        reserve(len);
+        memcpy(buffer.data() + used,s,len);
+        used += len;
+        return *this;
+    }
+    void flush()
+    {
+        if(used > 0)
+            fwrite(buffer.data(),1,used,f);
+        used = 0;
+        fflush(f);
+        return;
+    }
+
+private:
+    output_writer(const output_writer &) = delete; // lock the copy constructor
+    output_writer &operator=(const output_writer &) = delete; // and the copy assignment
+
+    void reserve(size_t len)
+    {
+        if(used + len > buffer.size())
+        {
+            fwrite(buffer.data(),1,used,f);
+            used = 0;
+        }
+        return;
+    }
+
+    FILE *f;
+    size_t used;
+    std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef COMMON_ROUTE_DAEMON_H
+#define COMMON_ROUTE_DAEMON_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <iostream>
+#include "router.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// Routing queries over a local (Unix domain) stream socket
+// Every message is a list of native-endian uint32 words
+//   request: op, count, then count (source, dest) pairs
+//   reply:   word count W, then W words
+// op ROUTE_NEXT_HOP replies the next hop of every pair (UINT_MAX if there is none)
+// op ROUTE_PATH replies, for every pair, the path length L and the L nodes from source to dest
+//   (L is 0 if dest cannot be reached)
+// op ROUTE_STOP has no pairs and no reply; the daemon stops
+// Requests on one connection are answered in order
+// Not available on Windows
+enum route_op
+{
+    ROUTE_STOP = 0,
+    ROUTE_NEXT_HOP = 1,
+    ROUTE_PATH = 2
+};
+
+#ifndef _WIN32
+// Send all of len bytes, false if the peer went away
+inline bool send_all(int fd,const void *data,size_t len)
+{
+    const char *p = (const char *)data;
+    while(len > 0)
+    {
+        ssize_t sent = ::send(fd,p,len,MSG_NOSIGNAL);
+        if(sent <= 0)
+            return false;
+        p += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+// Read exactly len bytes, false at the end of the stream
+inline bool recv_all(int fd,void *data,size_t len)
+{
+    char *p = (char *)data;
+    while(len > 0)
+    {
+        ssize_t got = ::recv(fd,p,len,0);
+        if(got <= 0)
+            return false;
+        p += got;
+        len -= got;
+    }
+    return true;
+}
+
+// Answers queries from one router until a client sends ROUTE_STOP
+// All clients are served by one thread polling their sockets
+class route_server
+{
+public:
+    route_server(): requests(0), pairs(0), listener(-1), n(0), routes(nullptr) {}
+    ~route_server()
+    {
+        close();
+    }
+
+    // Listen on the socket file path, replacing a stale one
+    bool listen(const char *_path,router &_routes,int _n)
+    {
+        close();
+        routes = &_routes;
+        n = _n;
+        sockaddr_un addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(strlen(_path) >= sizeof(addr.sun_path))
+            return false;
+        strcpy(addr.sun_path,_path);
+        path = _path;
+        listener = socket(AF_UNIX,SOCK_STREAM,0);
+        if(listener < 0)
+            return false;
+        unlink(_path);
+        if(bind(listener,(sockaddr *)&addr,sizeof(addr)) != 0 || ::listen(listener,64) != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void serve()
+    {
+        std::vector<pollfd> fds(1);
+        std::vector<connection> clients(1);
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        bool running = true;
+        while(running)
+        {
+            if(poll(fds.data(),fds.size(),-1) < 0)
+                continue;
+            if(fds[0].revents & POLLIN)
+            {
+                int client = accept(listener,nullptr,nullptr);
+                if(client >= 0)
+                {
+                    pollfd p;
+                    p.fd = client;
+                    p.events = POLLIN;
+                    p.revents = 0;
+                    fds.push_back(p);
+                    clients.push_back(connection());
+                }
+            }
+            for(size_t i=1; i<fds.size(); i++)
+            {
+                if(fds[i].revents == 0)
+                    continue;
+                bool open = receive(fds[i].fd,clients[i]) && answer(fds[i].fd,clients[i].words,running);
+                if(!open)
+                {
+                    ::close(fds[i].fd);
+                    fds.erase(fds.begin() + i);
+                    clients.erase(clients.begin() + i);
+                    i--;
+                }
+            }
+        }
+        for(size_t i=1; i<fds.size(); i++)
+            ::close(fds[i].fd);
+        return;
+    }
+
+    void close()
+    {
+        if(listener >= 0)
+        {
+            ::close(listener);
+            unlink(path.c_str());
+        }
+        listener = -1;
+        return;
+    }
+
+    long long requests;
+    long long pairs;
+
+private:
+    route_server(const route_server &) = delete; // lock the copy constructor
+    route_server &operator=(const route_server &) = delete; // and the copy assignment
+
+    // What a client sent but was not answered yet
+    struct connection
+    {
+        std::vector<uint32_t> words; // whole words
+        std::string tail;            // the bytes of a word split over two reads
+    };
+
+    // Append what the client sent to its pending words
+    bool receive(int fd,connection &c)
+    {
+        char chunk[1 << 16];
+        ssize_t got = ::recv(fd,chunk,sizeof(chunk),0);
+        if(got <= 0)
+            return false;
+        c.tail.append(chunk,got);
+        size_t whole = c.tail.size() / 4;
+        size_t old = c.words.size();
+        c.words.resize(old + whole);
+        memcpy(c.words.data() + old,c.tail.data(),whole * 4);
+        c.tail.erase(0,whole * 4);
+        return true;
+    }
+
+    // Answer every complete request in words
+    bool answer(int fd,std::vector<uint32_t> &words,bool &running)
+    {
+        size_t at = 0;
+        while(words.size() - at >= 2)
+        {
+            uint32_t op = words[at],count = words[at+1];
+            if(op == ROUTE_STOP)
+            {
+                running = false;
+                return false;
+            }
+            if(op != ROUTE_NEXT_HOP && op != ROUTE_PATH)
+                return false;
+            if(words.size() - at - 2 < (size_t)count * 2)
+                break;
+            const uint32_t *pair = words.data() + at + 2;
+            reply.assign(1,0);
+            for(uint32_t k=0; k<count; k++)
+            {
+                int source = (int)pair[2*k],dest = (int)pair[2*k+1];
+                if(op == ROUTE_NEXT_HOP)
+                    reply.push_back(valid(source,dest) ? routes->next_hop(source,dest) : UINT_MAX);
+                else
+                    path_of(source,dest);
+            }
+            reply[0] = reply.size() - 1;
+            requests++;
+            pairs += count;
+            if(!send_all(fd,reply.data(),reply.size() * 4))
+                return false;
+            at += 2 + (size_t)count * 2;
+        }
+        words.erase(words.begin(),words.begin() + at);
+        return true;
+    }
+
+    bool valid(int source,int dest) const
+    {
+        return source >= 0 && source < n && dest >= 0 && dest < n;
+    }
+
+    // Append the length and the nodes of the path, length 0 if the tables lead nowhere
+    void path_of(int source,int dest)
+    {
+        size_t length_at = reply.size();
+        reply.push_back(0);
+        if(!valid(source,dest))
+            return;
+        reply.push_back(source);
+        for(int hops=0; source != dest; hops++)
+        {
+            unsigned int next = routes->next_hop(source,dest);
+            if(next == UINT_MAX || hops >= n)
+            {
+                reply.resize(length_at + 1);
+                return;
+            }
+            source = next;
+            reply.push_back(source);
+        }
+        reply[length_at] = reply.size() - length_at - 1;
+        return;
+    }
+
+    int listener;
+    std::string path;
+    int n;
+    router *routes;
+    std::vector<uint32_t> reply;
+};
+
+// Serve routes on the socket path until a client sends ROUTE_STOP, reporting to stderr
+inline bool run_route_daemon(const char *path,router &routes,int n)
+{
+    route_server server;
+    if(!server.listen(path,routes,n))
+    {
+        std::cerr << "cannot listen on " << path << std::endl;
+        return false;
+    }
+    std::cerr << "serving routes of " << n << " nodes on " << path << std::endl;
+    server.serve();
+    std::cerr << "daemon stopped after " << server.requests << " requests, "
+              << server.pairs << " queries" << std::endl;
+    return true;
+}
+
+// Client side of the socket
+class route_client
+{
+public:
+    route_client(): fd(-1) {}
+    ~route_client()
+    {
+        close();
+    }
+
+    bool connect(const char *path)
+    {
+        close();
+        sockaddr_un addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(strlen(path) >= sizeof(addr.sun_path))
+            return false;
+        strcpy(addr.sun_path,path);
+        fd = socket(AF_UNIX,SOCK_STREAM,0);
+        if(fd < 0)
+            return false;
+        if(::connect(fd,(sockaddr *)&addr,sizeof(addr)) != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Send one request of count (source, dest) pairs and wait for its reply words
+    bool query(route_op op,const uint32_t *pairs,uint32_t count,std::vector<uint32_t> &reply)
+    {
+        uint32_t head[2] = {(uint32_t)op,count};
+        if(!send_all(fd,head,sizeof(head)) || !send_all(fd,pairs,(size_t)count * 8))
+            return false;
+        uint32_t words;
+        if(!recv_all(fd,&words,4))
+            return false;
+        reply.resize(words);
+        return recv_all(fd,reply.data(),(size_t)words * 4);
+    }
+    bool stop()
+    {
+        uint32_t head[2] = {ROUTE_STOP,0};
+        return send_all(fd,head,sizeof(head));
+    }
+
+    void close()
+    {
+        if(fd >= 0)
+            ::close(fd);
+        fd = -1;
+        return;
+    }
+
+private:
+    route_client(const route_client &) = delete; // lock the copy constructor
+    route_client &operator=(const route_client &) = delete; // and the copy assignment
+    int fd;
+};
+#endif
+
+#endif
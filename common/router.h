@@ -0,0 +1,24 @@
+#ifndef COMMON_ROUTER_H
+#define COMMON_ROUTER_H
+
+#include <cstddef>
+
+// What a node's sendTo asks for its next hop
+// Every way of keeping routes (full matrix, lazy cache, ...) implements this
+class router
+{
+public:
+    virtual ~router() {}
+    // Next hop from node toward dest, UINT_MAX (-1) if there is none
+    virtual unsigned int next_hop(int node,int dest) = 0;
+    // Next hop of one flow; only routes with several equal-cost hops look at the flow
+    virtual unsigned int flow_hop(int node,int dest,unsigned int flow)
+    {
+        (void)flow;
+        return next_hop(node,dest);
+    }
+    // Memory held by the routes
+    virtual size_t bytes() const = 0;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef COMMON_ROUTING_TABLE_H
+#define COMMON_ROUTING_TABLE_H
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include "router.h"
+
+// All nodes' routing tables in one row-major matrix
+// Row i is node i's routing table, entry (i,dest) is the next hop from i toward dest
+// The entry width is picked from n: 1 byte when n < 255, 2 bytes when n < 65535, else 4 bytes
+// The largest value of the width means "not set" and is read back as UINT_MAX (-1)
+// rows can be set below n to keep only some rows, e.g. a few cached columns stored as rows
+// The entries are either owned by the matrix or viewed in memory owned by someone else,
+// e.g. a shared memory segment; a viewed matrix is read only
+class routing_matrix : public router
+{
+public:
+    static const unsigned int NONE = UINT_MAX;
+
+    routing_matrix(): n(0), rows(0), width(0), external(nullptr) {}
+
+    void build(int _n,int _rows = -1)
+    {
+        n = _n;
+        rows = (_rows < 0) ? n : _rows;
+        width = entry_width(n);
+        external = nullptr;
+        // Every byte 0xFF makes every entry NONE whatever the width is
+        data.assign((size_t)rows * n * width,0xFF);
+        return;
+    }
+    // Read the n x n entries laid out as cells() lays them out without copying them
+    // They must stay alive as long as the matrix is used
+    void view(int _n,const unsigned char *_cells)
+    {
+        n = rows = _n;
+        width = entry_width(n);
+        data.clear();
+        external = _cells;
+        return;
+    }
+
+    unsigned int next_hop(int node,int dest)
+    {
+        return get(node,dest);
+    }
+
+    static int entry_width(int n)
+    {
+        if(n < 0xFF)
+            return 1;
+        if(n < 0xFFFF)
+            return 2;
+        return 4;
+    }
+
+    unsigned int get(int node,int dest) const
+    {
+        return decode(cells() + ((size_t)node * n + dest) * width,width);
+    }
+    // value -1 clears the entry
+    void set(int node,int dest,int value)
+    {
+        encode(data.data() + ((size_t)node * n + dest) * width,width,value);
+        return;
+    }
+
+    // One entry of width bytes at p, for other stores laid out like the matrix
+    static unsigned int decode(const unsigned char *p,int width)
+    {
+        switch(width)
+        {
+        case 1:
+            return (*p == 0xFF) ? NONE : *p;
+        case 2:
+        {
+            uint16_t v;
+            memcpy(&v,p,2);
+            return (v == 0xFFFF) ? NONE : v;
+        }
+        default:
+        {
+            uint32_t v;
+            memcpy(&v,p,4);
+            return v;
+        }
+        }
+    }
+    static void encode(unsigned char *p,int width,int value)
+    {
+        switch(width)
+        {
+        case 1:
+            *p = (unsigned char)value;
+            break;
+        case 2:
+        {
+            uint16_t v = (uint16_t)value;
+            memcpy(p,&v,2);
+            break;
+        }
+        default:
+        {
+            uint32_t v = (uint32_t)value;
+            memcpy(p,&v,4);
+            break;
+        }
+        }
+        return;
+    }
+
+    int size() const
+    {
+        return n;
+    }
+    int row_count() const
+    {
+        return rows;
+    }
+    int width_bytes() const
+    {
+        return width;
+    }
+    size_t bytes() const
+    {
+        return (size_t)rows * n * width;
+    }
+    // The raw entries, row after row
+    const unsigned char *cells() const
+    {
+        return (external != nullptr) ? external : data.data();
+    }
+
+private:
+    int n;
+    int rows;
+    int width;
+    std::vector<unsigned char> data;
+    const unsigned char *external;
+};
+
+#endif
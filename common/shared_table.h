@@ -0,0 +1,143 @@
+#ifndef COMMON_SHARED_TABLE_H
+#define COMMON_SHARED_TABLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include "routing_table.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// A routing_matrix published in a POSIX shared memory segment
+// The segment is a shared_table_header followed by routing_matrix::cells()
+// Any local process can map it read only and look up next hops without copying
+// or asking the daemon, e.g.
+//   shared_table shared;
+//   shared.open("/routes");
+//   unsigned int hop = shared.table().get(node,dest);
+// Not available on Windows
+struct shared_table_header
+{
+    uint32_t magic;   // SHARED_TABLE_MAGIC
+    uint32_t version; // SHARED_TABLE_VERSION
+    uint32_t nodes;
+    uint32_t width;   // bytes per entry, routing_matrix::entry_width(nodes)
+    uint64_t bytes;   // size of the entries after the header
+};
+
+const uint32_t SHARED_TABLE_MAGIC = 0x52504F4F; // "OOPR"
+const uint32_t SHARED_TABLE_VERSION = 1;
+
+#ifndef _WIN32
+// Copy table into the segment name (e.g. "/routes")
+// An older segment of that name is unlinked first, so its readers keep a whole table
+inline bool publish_table(const char *name,const routing_matrix &table)
+{
+    shm_unlink(name);
+    int fd = shm_open(name,O_CREAT | O_EXCL | O_RDWR,0644);
+    if(fd < 0)
+        return false;
+    size_t length = sizeof(shared_table_header) + table.bytes();
+    if(ftruncate(fd,length) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr,length,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    ::close(fd);
+    if(p == MAP_FAILED)
+        return false;
+    shared_table_header header;
+    memset(&header,0,sizeof(header));
+    header.magic = SHARED_TABLE_MAGIC;
+    header.version = SHARED_TABLE_VERSION;
+    header.nodes = table.size();
+    header.width = table.width_bytes();
+    header.bytes = table.bytes();
+    memcpy((char *)p + sizeof(header),table.cells(),table.bytes());
+    // The header goes last, so a reader never sees a complete header over half the entries
+    memcpy(p,&header,sizeof(header));
+    munmap(p,length);
+    return true;
+}
+
+// Remove the segment name; processes which mapped it keep their mapping
+inline void unpublish_table(const char *name)
+{
+    shm_unlink(name);
+    return;
+}
+
+// Read-only mapping of a published table
+class shared_table
+{
+public:
+    shared_table(): base(nullptr), length(0) {}
+    ~shared_table()
+    {
+        close();
+    }
+
+    bool open(const char *name)
+    {
+        close();
+        int fd = shm_open(name,O_RDONLY,0);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd,&st) != 0 || (size_t)st.st_size < sizeof(shared_table_header))
+        {
+            ::close(fd);
+            return false;
+        }
+        length = st.st_size;
+        void *p = mmap(nullptr,length,PROT_READ,MAP_SHARED,fd,0);
+        ::close(fd);
+        if(p == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+        base = (const char *)p;
+        shared_table_header header;
+        memcpy(&header,base,sizeof(header));
+        if(header.magic != SHARED_TABLE_MAGIC || header.version != SHARED_TABLE_VERSION ||
+           header.width != (uint32_t)routing_matrix::entry_width(header.nodes) ||
+           header.bytes != (uint64_t)header.nodes * header.nodes * header.width ||
+           sizeof(header) + header.bytes > length)
+        {
+            close();
+            return false;
+        }
+        matrix.view(header.nodes,(const unsigned char *)base + sizeof(header));
+        return true;
+    }
+    void close()
+    {
+        if(base != nullptr)
+            munmap((void *)base,length);
+        base = nullptr;
+        length = 0;
+        return;
+    }
+
+    // The mapped table; valid until close
+    const routing_matrix &table() const
+    {
+        return matrix;
+    }
+
+private:
+    shared_table(const shared_table &) = delete; // lock the copy constructor
+    shared_table &operator=(const shared_table &) = delete; // and the copy assignment
+    const char *base;
+    size_t length;
+    routing_matrix matrix;
+};
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef COMMON_TABLE_SNAPSHOT_H
+#define COMMON_TABLE_SNAPSHOT_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "graph.h"
+#include "mapped_file.h"
+#include "routing_table.h"
+
+// On-disk snapshot of a computed routing matrix
+//   header   snapshot_header, 56 bytes
+//   entries  routing_matrix::cells(), nodes x nodes entries of width bytes
+// The header names the program and options that built the table (variant) and a
+// fingerprint of the topology; a snapshot is only used when both match the current run,
+// otherwise the tables are rebuilt and the snapshot is written again
+// A matching snapshot is memory-mapped and read in place, so loading it costs no parsing
+const uint32_t SNAPSHOT_MAGIC = 0x53504F4F; // "OOPS"
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_HW1 = 1;
+const uint32_t SNAPSHOT_HW2 = 2;
+const uint32_t SNAPSHOT_MSBFS = 1 << 8; // hw1 built with the multi-source BFS
+const uint32_t SNAPSHOT_LUBY = 1 << 9;  // hw2 backbone from the Luby MIS; its seed is in the fingerprint
+
+struct snapshot_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t variant;     // SNAPSHOT_HW1 or SNAPSHOT_HW2, plus option bits
+    uint32_t nodes;
+    uint32_t width;       // bytes per entry
+    uint32_t reserved;
+    uint64_t fingerprint; // topology_fingerprint of the graph the table was built from
+    uint64_t bytes;       // size of the entries
+    uint64_t reserved2[2];
+};
+
+// FNV-1a over the CSR arrays and the per-slot weights if there are any
+// The neighbor order is hashed too: it decides how ties between equal paths are broken
+inline uint64_t topology_fingerprint(const csr_graph &graph,const int *weight = nullptr)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    auto mix = [&](const void *data,size_t len)
+    {
+        const unsigned char *p = (const unsigned char *)data;
+        for(size_t i=0; i<len; i++)
+        {
+            h ^= p[i];
+            h *= 0x100000001B3ULL;
+        }
+    };
+    int n = graph.size();
+    mix(&n,sizeof(n));
+    mix(graph.offsets(),sizeof(int) * ((size_t)n + 1));
+    mix(graph.neighbors(),sizeof(int) * (size_t)graph.edges());
+    if(weight != nullptr)
+        mix(weight,sizeof(int) * (size_t)graph.edges());
+    return h;
+}
+
+// Write the snapshot next to path first and rename it over path when complete,
+// so a reader never maps a half-written file
+inline bool save_snapshot(const char *path,uint32_t variant,uint64_t fingerprint,const routing_matrix &table)
+{
+    std::string temp = std::string(path) + ".tmp";
+    FILE *f = fopen(temp.c_str(),"wb");
+    if(f == nullptr)
+        return false;
+    snapshot_header h;
+    memset(&h,0,sizeof(h));
+    h.magic = SNAPSHOT_MAGIC;
+    h.version = SNAPSHOT_VERSION;
+    h.variant = variant;
+    h.nodes = table.size();
+    h.width = table.width_bytes();
+    h.fingerprint = fingerprint;
+    h.bytes = table.bytes();
+    bool ok = fwrite(&h,sizeof(h),1,f) == 1;
+    ok = ok && fwrite(table.cells(),1,table.bytes(),f) == table.bytes();
+    ok = (fclose(f) == 0) && ok;
+    if(ok)
+        ok = rename(temp.c_str(),path) == 0;
+    if(!ok)
+        remove(temp.c_str());
+    return ok;
+}
+
+// A mapped snapshot; the table reads its entries from the mapping
+class table_snapshot
+{
+public:
+    // False when the file is missing, damaged or built for another variant or topology
+    bool open(const char *path,uint32_t variant,uint64_t fingerprint)
+    {
+        if(!file.open(path) || file.size() < sizeof(snapshot_header))
+            return false;
+        snapshot_header h;
+        memcpy(&h,file.begin(),sizeof(h));
+        if(h.magic != SNAPSHOT_MAGIC || h.version != SNAPSHOT_VERSION || h.variant != variant ||
+           h.fingerprint != fingerprint || h.width != (uint32_t)routing_matrix::entry_width(h.nodes) ||
+           h.bytes != (uint64_t)h.nodes * h.nodes * h.width || file.size() != sizeof(h) + h.bytes)
+        {
+            file.close();
+            return false;
+        }
+        matrix.view(h.nodes,(const unsigned char *)file.begin() + sizeof(h));
+        return true;
+    }
+
+    // Read only: the entries live in the mapping
+    routing_matrix &table()
+    {
+        return matrix;
+    }
+
+private:
+    mapped_file file;
+    routing_matrix matrix;
+};
+
+#endif
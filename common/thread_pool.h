@@ -0,0 +1,57 @@
+#ifndef COMMON_THREAD_POOL_H
+#define COMMON_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// A fixed number of workers which share the jobs [0, count)
+// Workers take chunks of jobs from a shared counter, so the job order does not depend on timing
+// but any job may run on any worker; job(worker, i) must only write state owned by job i or worker
+class thread_pool
+{
+public:
+    thread_pool(int _threads = 1): threads(std::max(1,_threads)) {}
+
+    int size() const
+    {
+        return threads;
+    }
+
+    template<class F>
+    void run(int count,int chunk,F job)
+    {
+        if(threads == 1 || count <= chunk)
+        {
+            for(int i=0; i<count; i++)
+                job(0,i);
+            return;
+        }
+        std::atomic<int> next(0);
+        std::vector<std::thread> workers;
+        for(int w=0; w<threads; w++)
+        {
+            workers.push_back(std::thread([&,w]()
+            {
+                while(1)
+                {
+                    int begin = next.fetch_add(chunk);
+                    if(begin >= count)
+                        break;
+                    int end = std::min(count,begin + chunk);
+                    for(int i=begin; i<end; i++)
+                        job(w,i);
+                }
+            }));
+        }
+        for(int w=0; w<threads; w++)
+            workers[w].join();
+        return;
+    }
+
+private:
+    int threads;
+};
+
+#endif
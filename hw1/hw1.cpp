@@ -1,105 +1,658 @@
 #include <iostream>
 #include <vector>
-#include <queue>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <climits>
+#include <chrono>
+#include "../common/graph.h"
+#include "../common/binary_format.h"
+#include "../common/input_reader.h"
+#include "../common/output_writer.h"
+#include "../common/flow_query.h"
+#include "../common/flow_stream.h"
+#include "../common/shared_table.h"
+#include "../common/route_daemon.h"
+#include "../common/table_snapshot.h"
+#include "../common/disk_routing.h"
+#include "../common/bfs.h"
+#include "../common/ms_bfs.h"
+#include "../common/dial.h"
+#include "../common/dynamic_routing.h"
+#include "../common/lazy_routing.h"
+#include "../common/compact_routing.h"
+#include "../common/landmark_labels.h"
+#include "../common/ecmp_routing.h"
+#include "../common/link_load.h"
+#include "../common/routing_table.h"
+#include "../common/column_fill.h"
+#include "../common/thread_pool.h"
 using namespace std;
 
-// Use queue to implement BFS
-// Save information at last_node
-int BFS(int n,vector<int> graph[],int start,int dest)
+// All answers go through this buffered writer instead of cout
+output_writer out;
+
+class node
+{
+public:
+    unsigned int sendTo(int destinationID)
+    {
+        return routing_table->next_hop(id,destinationID);
+    }
+    // Next hop of flow flowID; differs from sendTo(dest) only with equal-cost routes
+    unsigned int sendTo(int destinationID,int flowID)
+    {
+        return routing_table->flow_hop(id,destinationID,flowID);
+    }
+    // Node initial, initial id and routing table
+    // The routing table is what the shared router holds for node id
+    void initial(int inputid,router *table)
+    {
+        id = inputid;
+        routing_table = table;
+        return;
+    }
+
+private:
+    router *routing_table;
+    unsigned int id;
+};
+
+// Build every node's routing table
+// The BFS tree rooted at dest gives every node's next hop toward dest,
+// so one BFS per destination fills a whole column of the tables
+// Destinations are spread over the pool and every worker keeps its own BFS engine
+// hops, if given, gets the hop count of every (node, dest) pair, -1 when unreachable
+void build_routing_table(int n,const csr_graph &graph,routing_matrix &table,thread_pool &pool,routing_matrix *hops = nullptr)
+{
+    bfs_graph bgraph;
+    bgraph.build(graph);
+    vector<bfs_engine> engines(pool.size());
+    for(int i=0; i<pool.size(); i++)
+        engines[i].bind(bgraph);
+    fill_columns(n,engines,table,pool,hops);
+    return;
+}
+
+// Build every node's routing table over weighted links
+// The tree rooted at dest now holds the lightest paths, found by the bucket-queue Dijkstra
+void build_routing_table_weighted(int n,const csr_graph &graph,const vector<int> &weight,routing_matrix &table,thread_pool &pool)
 {
-    queue<int> q;
-    int visited[n],last_node[n];
+    vector<dial_engine> engines(pool.size());
+    for(int i=0; i<pool.size(); i++)
+        engines[i].bind(graph,weight.data());
+    fill_columns(n,engines,table,pool);
+    return;
+}
+
+// Build every node's routing table with the bit-parallel multi-source BFS
+// One sweep finds the trees of ms_bfs_engine::LANES destinations at once
+// Ties between equal-length paths go to the lowest-id neighbor instead of the queue order,
+// so a path can differ from build_routing_table's but always has the same length
+// hops is filled as in build_routing_table: a node's parent is always one level closer
+void build_routing_table_ms(int n,const csr_graph &graph,routing_matrix &table,thread_pool &pool,routing_matrix *hops = nullptr)
+{
+    const int lanes = ms_bfs_engine::LANES;
+    vector<ms_bfs_engine> engines(pool.size());
+    for(int i=0; i<pool.size(); i++)
+        engines[i].bind(graph);
+    vector<int> dests(n);
     for(int i=0; i<n; i++)
     {
-        visited[i] = 0;
-        last_node[i] = -1;
+        dests[i] = i;
+        table.set(i,i,i);
+        if(hops != nullptr)
+            hops->set(i,i,0);
     }
-    q.push(start);
-    visited[start] = 1;
+    pool.run((n + lanes - 1) / lanes,1,[&](int worker,int batch)
+    {
+        int first = batch * lanes;
+        int count = min(lanes,n - first);
+        engines[worker].run(&dests[first],count,[&](int i,int lane,int last_node)
+        {
+            table.set(i,first + lane,last_node);
+            if(hops != nullptr)
+                hops->set(i,first + lane,hops->get(last_node,first + lane) + 1);
+        });
+    });
+    return;
+}
 
-    while(!q.empty())
+// Print the path of one flow by following the routing tables
+void print_flow(node nodes[],int flowID,int source,int dest)
+{
+    out << flowID << " ";
+    while(source != dest)
     {
-        int f = q.front();
-        q.pop();
-        if(f == dest)
-            break;
-        for(int i=0; i<graph[f].size(); i++)
+        out << source << " ";
+        source = nodes[source].sendTo(dest,flowID);
+    }
+    out << dest << "\n";
+    return;
+}
+
+// Walk every flow again and count it on each link of its path
+void measure_link_load(const csr_graph &graph,node nodes[],const int *flows,int count)
+{
+    link_load load;
+    load.build(graph);
+    for(int i=0; i<count; i++)
+    {
+        int flowID = flows[3*i],source = flows[3*i+1],dest = flows[3*i+2];
+        while(source != dest)
         {
-            if(visited[graph[f][i]] == 0)
-            {
-                q.push(graph[f][i]);
-                last_node[graph[f][i]] = f;
-                visited[graph[f][i]] = 1;
-            }
+            int next = nodes[source].sendTo(dest,flowID);
+            load.add(source,next);
+            source = next;
         }
     }
-    return last_node[dest];
+    load.print(cerr);
+    return;
 }
 
-class node
+// Apply the link updates in file path: a count, then one "op a b" per line
+// op 1 adds the link a-b and op 0 removes it; an update naming no node is skipped
+bool apply_updates(const char *path,dynamic_routing &routing)
 {
-public:
-    unsigned int sendTo(int destinationID)
+    ifstream file(path);
+    if(!file)
+        return false;
+    int count,op,a,b;
+    file >> count;
+    for(int i=0; i<count && file >> op >> a >> b; i++)
     {
-        return routing_table[destinationID];
+        long long changed = (op == 1) ? routing.add_link(a,b) : routing.remove_link(a,b);
+        cerr << (op == 1 ? "add" : "remove") << " link " << a << " " << b << ": ";
+        if(changed < 0)
+            cerr << "no such node, skipped" << endl;
+        else
+            cerr << changed << " routing entries changed" << endl;
     }
-    // Make routing_table when node initial
-    void initial(int n,int inputid,vector<int> graph[])
+    return true;
+}
+
+// Read a byte count with an optional K, M or G suffix
+long long parse_size(const char *text)
+{
+    char *end;
+    long long size = strtoll(text,&end,10);
+    if(*end == 'K' || *end == 'k')
+        size <<= 10;
+    else if(*end == 'M' || *end == 'm')
+        size <<= 20;
+    else if(*end == 'G' || *end == 'g')
+        size <<= 30;
+    return size;
+}
+
+// Time next-hop lookups between pseudo-random node pairs
+// Reports the table size per entry and the mean lookup time on stderr
+void bench_lookups(int n,router &routes)
+{
+    if(n == 0)
+        return;
+    const int lookups = 1 << 22;
+    unsigned int seed = 12345,check = 0;
+    auto begin = chrono::steady_clock::now();
+    for(int i=0; i<lookups; i++)
     {
-        id = inputid;
-        // Set memory to routing_table
-        routing_table = new int[n];
-        // Set routing_table[i]
-        for(int i=0; i<n; i++)
+        seed = seed * 1103515245 + 12345;
+        int source = (int)((seed >> 8) % n);
+        seed = seed * 1103515245 + 12345;
+        int dest = (int)((seed >> 8) % n);
+        check += routes.next_hop(source,dest);
+    }
+    double ns = chrono::duration<double,nano>(chrono::steady_clock::now() - begin).count();
+    cerr << "routing bench: " << routes.bytes() << " bytes, "
+         << (double)routes.bytes() / ((double)n * n) << " bytes/entry, "
+         << ns / lookups << " ns/lookup (check " << check << ")" << endl;
+    return;
+}
+
+int main(int argc,char *argv[])
+{
+    // Read options
+    // --threads N : build the routing tables with N threads
+    // --msbfs     : build the routing tables with the multi-source BFS
+    // --binary F  : read the topology and flows from binary container F instead of stdin
+    // --batch     : load all flows first and answer them on the thread pool
+    // --hops      : print only the hop count of every flow (implies --batch)
+    // --updates F : add and remove the links listed in F and repair the routing tables
+    // --lazy B    : build each destination's routes on first use, caching at most B bytes (K/M/G suffix);
+    //               B must hold one destination's column, n bytes below 255 nodes, 2n below 65535, else 4n
+    // --compact   : keep the routing tables as runs of equal next hops
+    // --bench     : time random next-hop lookups and report them with the table size
+    // --pll       : answer flows from a pruned landmark labeling distance oracle instead of routing tables
+    // --ecmp      : keep every equal-cost next hop and spread the flows over them by flowID
+    // --link-load : report how many flows cross every link
+    // --weighted  : every link line ends with an integer weight from 0 to 2147483647; route over the lightest paths
+    // --stream    : answer every flow line as soon as it is read and report the latencies at exit
+    // --daemon S  : keep the tables and answer path and next-hop queries on the Unix socket S
+    // --shm NAME  : publish the routing tables in the shared memory segment NAME (e.g. /routes)
+    // --snapshot F: map the routing tables from snapshot F if it matches the topology, else build and save them
+    // --disk F    : keep the routing tables in file F instead of memory, reading them through a page cache
+    // --memory B  : memory for --disk's column blocks and page cache (K/M/G suffix, default 64M);
+    //               B must hold one 64K page and one destination's column of n entries;
+    //               building the file also takes about 32 bytes per node per thread and 16 per link outside B
+    int threads = 1;
+    bool multi_source = false;
+    const char *binary_path = nullptr;
+    bool batch = false,hops_only = false;
+    const char *updates_path = nullptr;
+    long long lazy_budget = -1;
+    bool compact = false,bench = false,landmarks = false;
+    bool ecmp = false,measure_load = false;
+    bool weighted = false,stream = false;
+    const char *daemon_path = nullptr,*shm_name = nullptr;
+    const char *snapshot_path = nullptr;
+    const char *disk_path = nullptr;
+    long long memory_budget = 64LL << 20;
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--threads" && i+1 < argc)
+            threads = atoi(argv[++i]);
+        else if(arg == "--msbfs")
+            multi_source = true;
+        else if(arg == "--binary" && i+1 < argc)
+            binary_path = argv[++i];
+        else if(arg == "--batch")
+            batch = true;
+        else if(arg == "--hops")
+            batch = hops_only = true;
+        else if(arg == "--updates" && i+1 < argc)
+            updates_path = argv[++i];
+        else if(arg == "--lazy" && i+1 < argc)
+            lazy_budget = parse_size(argv[++i]);
+        else if(arg == "--compact")
+            compact = true;
+        else if(arg == "--bench")
+            bench = true;
+        else if(arg == "--pll")
+            landmarks = true;
+        else if(arg == "--ecmp")
+            ecmp = true;
+        else if(arg == "--link-load")
+            measure_load = true;
+        else if(arg == "--weighted")
+            weighted = true;
+        else if(arg == "--stream")
+            stream = true;
+        else if(arg == "--daemon" && i+1 < argc)
+            daemon_path = argv[++i];
+        else if(arg == "--shm" && i+1 < argc)
+            shm_name = argv[++i];
+        else if(arg == "--snapshot" && i+1 < argc)
+            snapshot_path = argv[++i];
+        else if(arg == "--disk" && i+1 < argc)
+            disk_path = argv[++i];
+        else if(arg == "--memory" && i+1 < argc)
+            memory_budget = parse_size(argv[++i]);
+    }
+    bool other_tables = lazy_budget >= 0 || compact || landmarks || ecmp || disk_path != nullptr;
+    if(other_tables && (shm_name != nullptr || snapshot_path != nullptr))
+    {
+        cerr << "--shm and --snapshot keep the full routing tables and cannot be used with --lazy, --compact, --pll, --ecmp or --disk" << endl;
+        return 1;
+    }
+    if(snapshot_path != nullptr && updates_path != nullptr)
+    {
+        cerr << "--updates changes the routing tables and cannot be used with --snapshot" << endl;
+        return 1;
+    }
+    if(other_tables && updates_path != nullptr)
+    {
+        cerr << "--updates needs the full routing tables and cannot be used with --lazy, --compact, --pll, --ecmp or --disk" << endl;
+        return 1;
+    }
+    if(stream && measure_load)
+    {
+        cerr << "--stream answers flows without keeping them and cannot be used with --link-load" << endl;
+        return 1;
+    }
+
+    int n;
+    csr_graph graph;
+    vector<int> nodeA,nodeB;
+    vector<int> weight,slot_weight;
+    input_reader in;
+    binary_input bin;
+    if(binary_path != nullptr && weighted)
+    {
+        cerr << "the binary container has no link weights and cannot be used with --weighted" << endl;
+        return 1;
+    }
+    if(binary_path != nullptr)
+    {
+        // Use the mapped CSR arrays as the graph
+        if(!bin.open(binary_path,BINARY_FLOWS))
+        {
+            cerr << "cannot load " << binary_path << ": " << bin.error() << endl;
+            return 1;
+        }
+        n = bin.nodes();
+        graph.view(n,bin.offsets(),bin.neighbors());
+    }
+    else
+    {
+        int links;
+        in >> n >> links;
+        if(!in)
+        {
+            cerr << "the input is incomplete" << endl;
+            return 1;
+        }
+        // Read input links
+        int linkID;
+        nodeA.resize(links);
+        nodeB.resize(links);
+        weight.assign(links,1);
+        for(int i=0; i<links; i++)
+        {
+            in >> linkID >> nodeA[i] >> nodeB[i];
+            if(weighted)
+            {
+                long long w;
+                in >> w;
+                if(in && (w < 0 || w > INT_MAX))
+                {
+                    cerr << "link " << linkID << " has weight " << w << ", weights must be from 0 to " << INT_MAX << endl;
+                    return 1;
+                }
+                weight[i] = (int)w;
+            }
+        }
+        if(!in)
+        {
+            cerr << "the input is incomplete" << endl;
+            return 1;
+        }
+        int bad = csr_graph::bad_link(n,nodeA,nodeB);
+        if(bad >= 0)
+        {
+            cerr << "link " << bad << " joins " << nodeA[bad] << " and " << nodeB[bad] << ", node ids must be from 0 to " << n - 1 << endl;
+            return 1;
+        }
+        // Save the node i's neighbor in graph
+        graph.build(n,nodeA,nodeB);
+        // Weights all 1 are plain hop counts, which the BFS handles faster
+        for(int i=0; i<links; i++)
+        {
+            if(weight[i] != 1)
+            {
+                graph.slot_values(nodeA,nodeB,weight,slot_weight);
+                break;
+            }
+        }
+    }
+    if(!slot_weight.empty() && (other_tables || updates_path != nullptr))
+    {
+        cerr << "--lazy, --compact, --pll, --ecmp, --disk and --updates route by hop count and cannot be used with link weights" << endl;
+        return 1;
+    }
+
+    // Build routing_table, or leave it to the lazy router
+    thread_pool pool(threads);
+    routing_matrix table;
+    // The hop counts the link updates start from, recorded while the table is built
+    routing_matrix hops;
+    routing_matrix *record_hops = (updates_path != nullptr) ? &hops : nullptr;
+    if(record_hops != nullptr)
+        hops.build(n);
+    lazy_router lazy;
+    compact_router compressed;
+    table_snapshot snapshot;
+    disk_router disk;
+    routing_matrix *full = &table;
+    landmark_oracle oracle;
+    ecmp_router equal_cost;
+    router *routes = &table;
+    if(ecmp)
+    {
+        equal_cost.build(graph,pool);
+        routes = &equal_cost;
+        cerr << "ecmp routing: " << equal_cost.set_count() << " distinct next-hop sets, "
+             << equal_cost.bytes() << " bytes" << endl;
+    }
+    else if(landmarks)
+    {
+        oracle.build(graph);
+        routes = &oracle;
+        cerr << "landmark labels: " << oracle.entries() << " entries, "
+             << (double)oracle.entries() / max(n,1) << " per node, " << oracle.bytes() << " bytes" << endl;
+    }
+    else if(lazy_budget >= 0)
+    {
+        if(!lazy.build(graph,lazy_budget))
+        {
+            cerr << "--lazy needs room for at least one column, " << lazy_router::column_bytes(n) << " bytes" << endl;
+            return 1;
+        }
+        routes = &lazy;
+    }
+    else if(compact)
+    {
+        compressed.build(graph,pool);
+        routes = &compressed;
+    }
+    else if(disk_path != nullptr)
+    {
+        bool reused;
+        if(memory_budget < 0 || (size_t)memory_budget < disk_router::min_budget(n))
+        {
+            cerr << "--memory needs room for one page and one column, " << disk_router::min_budget(n) << " bytes" << endl;
+            return 1;
+        }
+        if(!disk.build(disk_path,graph,memory_budget,pool,reused))
+        {
+            cerr << "cannot write " << disk_path << endl;
+            return 1;
+        }
+        routes = &disk;
+        cerr << "routing tables " << (reused ? "reused from " : "written to ") << disk_path << endl;
+    }
+    else
+    {
+        // A snapshot is only used when it was built by the same builder from the same topology
+        uint32_t variant = SNAPSHOT_HW1 | (multi_source ? SNAPSHOT_MSBFS : 0);
+        uint64_t fingerprint = 0;
+        if(snapshot_path != nullptr)
+            fingerprint = topology_fingerprint(graph,slot_weight.empty() ? nullptr : slot_weight.data());
+        if(snapshot_path != nullptr && snapshot.open(snapshot_path,variant,fingerprint))
         {
-            if(i != id)
-                routing_table[i] = BFS(n,graph,i,id);
+            full = &snapshot.table();
+            routes = full;
+            cerr << "routing tables loaded from " << snapshot_path << endl;
+        }
+        else
+        {
+            table.build(n);
+            if(!slot_weight.empty())
+                build_routing_table_weighted(n,graph,slot_weight,table,pool);
+            else if(multi_source)
+                build_routing_table_ms(n,graph,table,pool,record_hops);
             else
-                routing_table[i] = i;
+                build_routing_table(n,graph,table,pool,record_hops);
+            if(snapshot_path != nullptr)
+            {
+                if(save_snapshot(snapshot_path,variant,fingerprint,table))
+                    cerr << "routing tables saved to " << snapshot_path << endl;
+                else
+                    cerr << "cannot write " << snapshot_path << endl;
+            }
         }
-        return;
     }
+    // Initial nodes
+    vector<node> nodes(n);
+    for(int i=0;i<n;i++)
+        nodes[i].initial(i,routes);
 
-private:
-    int *routing_table;
-    unsigned int id;
-};
+    if(bench)
+        bench_lookups(n,*routes);
+    if(compact)
+    {
+        if(compressed.dense())
+            cerr << "compact routing: the runs are not smaller, dense tables of " << compressed.bytes() << " bytes kept" << endl;
+        else
+            cerr << "compact routing: " << compressed.runs() << " runs, "
+                 << (double)compressed.runs() / max(n,1) << " runs per node, " << compressed.bytes() << " bytes" << endl;
+    }
 
-int main()
-{
-    int n,links;
-    cin >> n >> links;
-    // Read input links
-    int linkID,nodeA,nodeB;
-    vector<int> graph[n];
-    for(int i=0; i<links; i++)
-    {
-        cin >> linkID >> nodeA >> nodeB;
-        // Save the node i's neighbor in graph[i]
-        graph[nodeA].push_back(nodeB);
-        graph[nodeB].push_back(nodeA);
-    }
-    node nodes[n];
-    // Initial nodes and build routing_table
-    for(int i=0;i<n;i++)
-        nodes[i].initial(n,i,graph);
+    // Repair the routing tables after every link update
+    // The flows then travel the updated topology
+    dynamic_routing routing;
+    const csr_graph *topology = &graph;
+    if(updates_path != nullptr)
+    {
+        if(binary_path != nullptr)
+            graph.link_list(nodeA,nodeB);
+        routing.build(n,nodeA,nodeB,&table,&pool,hops);
+        topology = &routing.topology();
+        if(!apply_updates(updates_path,routing))
+        {
+            cerr << "cannot load " << updates_path << endl;
+            return 1;
+        }
+    }
 
-    // Read input flows
-    int flows;
-    cin >> flows;
-    int flowID,source,dest;
-    for(int i=0; i<flows; i++)
+    // Publish the tables and answer queries from other processes instead of reading flows
+    if(shm_name != nullptr || daemon_path != nullptr)
     {
-        cin >> flowID >> source >> dest;
-        cout << flowID << " ";
+#ifndef _WIN32
+        if(shm_name != nullptr)
+        {
+            if(!publish_table(shm_name,*full))
+            {
+                cerr << "cannot publish the routing tables as " << shm_name << endl;
+                return 1;
+            }
+            cerr << "routing tables published as " << shm_name << endl;
+        }
+        if(daemon_path != nullptr)
+        {
+            bool ok = run_route_daemon(daemon_path,*routes,n);
+            if(shm_name != nullptr)
+                unpublish_table(shm_name);
+            return ok ? 0 : 1;
+        }
+#else
+        cerr << "--daemon and --shm need POSIX sockets and shared memory" << endl;
+        return 1;
+#endif
+    }
 
-        // Print answer
-        while(source != dest)
+    // Read input flows
+    // They are kept when the link load is measured afterwards
+    vector<int> flow_list;
+    const int *flows = nullptr;
+    int flow_count = 0;
+    latency_histogram latency;
+    if(stream)
+    {
+        // Flows come from stdin even with --binary
+        out.flush();
+        stream_flows(in,out,n,latency,[&](int source,int dest,int flowID)
         {
-            cout << source << " ";
-            source = nodes[source].sendTo(dest);
+            return (int)nodes[source].sendTo(dest,flowID);
+        });
+        cerr << "stream: " << latency.size() << " flows, ";
+        latency.print(cerr);
+        cerr << endl;
+    }
+    else if(batch)
+    {
+        // Load all flows, then answer them on the pool
+        if(binary_path != nullptr)
+        {
+            flow_count = bin.event_count(0);
+            flows = bin.event(0,0);
         }
-        cout << dest << "\n";
+        else
+        {
+            in >> flow_count;
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            flow_list.resize(3 * flow_count);
+            for(int i=0; i<3*flow_count; i++)
+                in >> flow_list[i];
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            flows = flow_list.data();
+        }
+        auto next = [&](int source,int dest,int flowID)
+        {
+            return (int)nodes[source].sendTo(dest,flowID);
+        };
+        if(landmarks)
+        {
+            // The oracle knows the hop count without walking the path
+            answer_flows(flows,flow_count,hops_only,pool,out,next,[&](int source,int dest,int)
+            {
+                return oracle.distance(source,dest);
+            });
+        }
+        else
+            answer_flows(flows,flow_count,hops_only,pool,out,next);
+    }
+    else if(binary_path != nullptr)
+    {
+        for(int i=0; i<bin.event_count(0); i++)
+        {
+            const int *flow = bin.event(0,i);
+            print_flow(nodes.data(),flow[0],flow[1],flow[2]);
+        }
+        flow_count = bin.event_count(0);
+        flows = (flow_count > 0) ? bin.event(0,0) : nullptr;
+    }
+    else
+    {
+        in >> flow_count;
+        if(!in)
+        {
+            cerr << "the flow list is incomplete" << endl;
+            return 1;
+        }
+        int flowID,source,dest;
+        for(int i=0; i<flow_count; i++)
+        {
+            in >> flowID >> source >> dest;
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            print_flow(nodes.data(),flowID,source,dest);
+            if(measure_load)
+            {
+                flow_list.push_back(flowID);
+                flow_list.push_back(source);
+                flow_list.push_back(dest);
+            }
+        }
+        flows = flow_list.data();
+    }
+
+    // Flush the answers before the report goes to stderr
+    if(measure_load)
+    {
+        out.flush();
+        measure_link_load(*topology,nodes.data(),flows,flow_count);
+    }
+    if(disk_path != nullptr)
+    {
+        cerr << "disk routing: " << disk.pages() << " cached pages (" << disk.bytes() << " bytes), "
+             << disk.hits() << " hits, " << disk.misses() << " misses" << endl;
+    }
+    if(lazy_budget >= 0)
+    {
+        cerr << "lazy routing: " << lazy.slots() << " cached destinations (" << lazy.bytes() << " bytes), "
+             << lazy.hits << " hits, " << lazy.misses << " misses, " << lazy.evictions << " evictions" << endl;
     }
     return 0;
 }
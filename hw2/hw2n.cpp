@@ -1,132 +1,75 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <chrono>
+#include "../common/graph.h"
+#include "../common/binary_format.h"
+#include "../common/input_reader.h"
+#include "../common/output_writer.h"
+#include "../common/flow_query.h"
+#include "../common/flow_stream.h"
+#include "../common/shared_table.h"
+#include "../common/route_daemon.h"
+#include "../common/table_snapshot.h"
+#include "../common/bfs.h"
+#include "../common/dial.h"
+#include "../common/luby_mis.h"
+#include "../common/routing_table.h"
+#include "../common/thread_pool.h"
 using namespace std;
 
+// All answers go through this buffered writer instead of cout
+output_writer out;
+
 class node
 {
 public:
     unsigned int sendTo(int destinationID)
     {
-        return routing_table[destinationID];
+        return routing_table->get(id,destinationID);
     }
     // Node initial, initial id and routing table
-    void initial(int n,int inputid)
+    // The routing table is row id of the shared routing matrix
+    // Every entry starts as -1 except the node itself
+    void initial(int inputid,routing_matrix *table)
     {
         id = inputid;
-        // Set memory to routing_table
-        routing_table = new int[n];
-
-        // Initial routing_table
-        for(int i=0; i<n; i++)
-            routing_table[i] = -1;
-        routing_table[id] = id;
-
+        routing_table = table;
+        routing_table->set(id,id,id);
+        return;
+    }
+    // Node initial with a routing table which is already filled, e.g. a loaded snapshot
+    void attach(int inputid,routing_matrix *table)
+    {
+        id = inputid;
+        routing_table = table;
         return;
     }
     void routing_table_set(int dest,int value)
     {
-        routing_table[dest] = value;
+        routing_table->set(id,dest,value);
         return;
     }
     void debug(int n)
     {
         for(int i=0; i<n; i++)
-            cout <<routing_table[i] << " ";
-        cout << "\n";
+            out << (int)routing_table->get(id,i) << " ";
+        out << "\n";
     }
 private:
-    int *routing_table;
+    routing_matrix *routing_table;
     unsigned int id;
 };
 
-// BFS to find route
-int BFS(int n,vector<int> graphex[],int start,int dest,int CDS[],node nodes[])
-{
-    queue<int> q;
-    int visited[n],last_node[n];
-    for(int i=0; i<n; i++)
-    {
-        visited[i] = 0;
-        last_node[i] = -1;
-    }
-
-    q.push(start);
-    visited[start] = 1;
-
-    while(!q.empty())
-    {
-        int f = q.front();
-        q.pop();
-        if(f == dest)
-            break;
-        for(int i=0; i<graphex[f].size(); i++)
-        {
-            if(visited[graphex[f][i]] == 0)
-            {
-                q.push(graphex[f][i]);
-                last_node[graphex[f][i]] = f;
-                visited[graphex[f][i]] = 1;
-            }
-        }
-    }
-
-    return last_node[dest];
-}
-
-// BFS in three steps to find CDS
-void BFS_3(int n,vector<int> graph[],int start,int dest,int CDS[],node nodes[])
-{
-    queue<int> q;
-    int visited[n],last_node[n],level[n];
-    for(int i=0; i<n; i++)
-    {
-        visited[i] = 0;
-        last_node[i] = -1;
-        level[i] = 0;
-    }
-    q.push(start);
-    visited[start] = 1;
-
-    while(!q.empty())
-    {
-        int f = q.front();
-        q.pop();
-        if(f == dest)
-            break;
-        if(level[f] == 4)
-            return;
-        for(int i=0; i<graph[f].size(); i++)
-        {
-            if(visited[graph[f][i]] == 0)
-            {
-                q.push(graph[f][i]);
-                last_node[graph[f][i]] = f;
-                visited[graph[f][i]] = 1;
-                // Set level to find distance < 3
-                level[graph[f][i]] = level[f] + 1;
-            }
-        }
-    }
-
-    int tmp = dest;
-    // Set route into routing table
-    while(tmp != start)
-    {
-        CDS[tmp] = 1;
-        nodes[tmp].routing_table_set(start,last_node[tmp]);
-        tmp = last_node[tmp];
-    }
-    CDS[start] = 1;
-    return;
-}
-
-void build_MIS(int n,vector<int> graph[],int MIS[])
+void build_MIS(int n,const csr_graph &graph,int MIS[])
 {
-    int node_active[n];
     // Mark all node active
-    for(int i=0; i<n; i++)
-        node_active[i] = 1;
+    vector<int> node_active(n,1);
 
     for(int i=0; i<n; i++)
     {
@@ -134,10 +77,10 @@ void build_MIS(int n,vector<int> graph[],int MIS[])
         if(node_active[i] == 1)
         {
             int larger = 0;
-            for(int j=0; j<graph[i].size(); j++)
+            for(const int *it=graph.begin(i); it!=graph.end(i); it++)
             {
                 // Find all active neighbor
-                if( (node_active[graph[i][j]] == 1) && (i > graph[i][j]) )
+                if( (node_active[*it] == 1) && (i > *it) )
                     larger = 1;
             }
             // If they are all smaller than i
@@ -145,105 +88,245 @@ void build_MIS(int n,vector<int> graph[],int MIS[])
             if(larger == 0)
             {
                 MIS[i] = 1;
-                for(int j=0; j<graph[i].size(); j++)
-                    node_active[graph[i][j]] = 0;
+                for(const int *it=graph.begin(i); it!=graph.end(i); it++)
+                    node_active[*it] = 0;
             }
         }
     }
     return;
 }
 
-void build_CDS(int n,vector<int> graph[],int MIS[],int CDS[],node nodes[])
+// Do route from a MIS node to every MIS node close to it
+// One BFS from MIS node i reaches the MIS nodes within 3 hops and the first node found
+// 4 hops away, which is also routed to when it is a MIS node
+// Every node on those routes joins the CDS and points toward i in its routing table
+// The searches share their scratch state and reset only the nodes they reached
+void build_CDS(int n,const csr_graph &graph,int MIS[],int CDS[],node nodes[])
 {
-    // Do route from a MIS node to another
+    vector<int> level(n,-1),last_node(n,-1),q(n),routed(n,-1);
     for(int i=0;i<n;i++)
     {
-        if(MIS[i] == 1)
+        if(MIS[i] != 1)
+            continue;
+        int head = 0,tail = 0;
+        q[tail++] = i;
+        level[i] = 0;
+        while(head < tail)
         {
-            for(int j=0;j<n;j++)
+            int f = q[head++];
+            // Level 4 nodes are found but not searched from
+            if(level[f] == 4)
+                break;
+            for(const int *it=graph.begin(f); it!=graph.end(f); it++)
             {
-                if(MIS[j] == 1)
+                if(level[*it] < 0)
                 {
-                    BFS_3(n,graph,i,j,CDS,nodes);
+                    q[tail++] = *it;
+                    last_node[*it] = f;
+                    level[*it] = level[f] + 1;
                 }
             }
         }
+
+        // Set route into routing table, up to where an earlier route from i joined
+        for(int k=0; k<tail; k++)
+        {
+            int j = q[k];
+            bool first_far = (level[j] == 4 && (k == 0 || level[q[k-1]] < 4));
+            if(MIS[j] != 1 || (level[j] == 4 && !first_far))
+                continue;
+            for(int tmp=j; tmp!=i && routed[tmp]!=i; tmp=last_node[tmp])
+            {
+                CDS[tmp] = 1;
+                routed[tmp] = i;
+                nodes[tmp].routing_table_set(i,last_node[tmp]);
+            }
+        }
+        CDS[i] = 1;
+
+        for(int k=0; k<tail; k++)
+        {
+            level[q[k]] = -1;
+            last_node[q[k]] = -1;
+        }
     }
     return;
 }
 // If the node is not in CDS
 // Set its proxy node
-void set_proxy(int n,vector<int> graph[],int CDS[],node nodes[])
+// Engine is masked_bfs_engine, or dial_engine when the links are weighted; one per pool worker
+// Nodes out of the CDS have no links into them on the backbone, so every route toward such
+// a node i goes over the backbone tree rooted at proxy(i), and a route found from one
+// of them is -1 until the node itself fills its routing table with its proxy
+// So the nodes are grouped by proxy and every proxy's tree is searched once, in parallel
+template<class Engine>
+void set_proxy(int n,const csr_graph &graph,int CDS[],node nodes[],vector<Engine> &engines,thread_pool &pool)
 {
+    // Find the smallest node in CDS as its proxy
+    vector<int> proxy(n,n),first(n+1,0),members;
     for(int i=0;i<n;i++)
     {
         if(CDS[i] == 0)
         {
-            int proxy = n;
-            // Find the smallest node in CDS as its proxy
-            for(int j=0;j<graph[i].size();j++)
+            for(const int *it=graph.begin(i); it!=graph.end(i); it++)
             {
-                if(proxy > graph[i][j] && CDS[graph[i][j]] == 1)
-                    proxy = graph[i][j];
+                if(proxy[i] > *it && CDS[*it] == 1)
+                    proxy[i] = *it;
             }
             // Set their routing table as their proxy
-            // Then, Set every node's routing table to them as to their proxy
             for(int j=0;j<n;j++)
             {
                 if(nodes[i].sendTo(j) == -1)
-                    nodes[i].routing_table_set(j,proxy);
-                if(nodes[j].sendTo(i) == -1)
-                {
-                    int tmp = BFS(n,graph,proxy,j,CDS,nodes);
-                    nodes[j].routing_table_set(i,tmp);
-                }
+                    nodes[i].routing_table_set(j,proxy[i]);
             }
+            if(proxy[i] < n)
+                first[proxy[i]+1]++;
         }
     }
-}
-
-// To avoid BFS into a node which is not CDS
-void kill_graph(int n,vector<int> graph[],vector<int> graphex[],int CDS[])
-{
+    // The nodes of every proxy, in id order
+    vector<int> proxies;
+    for(int p=0;p<n;p++)
+    {
+        if(first[p+1] > 0)
+            proxies.push_back(p);
+        first[p+1] += first[p];
+    }
+    members.resize(first[n]);
+    vector<int> fill(first.begin(),first.end()-1);
     for(int i=0;i<n;i++)
     {
-        for(int j=0;j<graph[i].size();j++)
+        if(CDS[i] == 0 && proxy[i] < n)
+            members[fill[proxy[i]]++] = i;
+    }
+
+    // Then, Set every CDS node's routing table to them as to their proxy
+    pool.run(proxies.size(),1,[&](int worker,int k)
+    {
+        int p = proxies[k];
+        engines[worker].run(p);
+        const int *last_node = engines[worker].parents();
+        for(int m=first[p]; m<first[p+1]; m++)
         {
-            if(CDS[graph[i][j]] == 1)
-                graphex[i].push_back(graph[i][j]);
+            int i = members[m];
+            for(int j=0;j<n;j++)
+            {
+                if(CDS[j] == 1 && nodes[j].sendTo(i) == -1)
+                    nodes[j].routing_table_set(i,last_node[j]);
+            }
         }
-    }
+    });
     return;
 }
 
-void set_routing_table(int n,vector<int> graph[],node nodes[])
+// How the MIS of the backbone is chosen
+struct mis_options
 {
-    // Initial MIS and CDS
-    int MIS[n],CDS[n];
-    for(int i=0;i<n;i++)
-    {
-        MIS[i] = 0;
-        CDS[i] = 0;
-    }
-    build_MIS(n,graph,MIS);
-    build_CDS(n,graph,MIS,CDS,nodes);
+    bool luby;     // Luby rounds on the thread pool instead of the greedy sweep
+    uint64_t seed; // seed of the Luby priorities
+};
 
-    vector<int> graphex[n];
-    kill_graph(n,graph,graphex,CDS);
-    set_proxy(n,graphex,CDS,nodes);
+// What the routing table build did, reported by --stats
+struct build_stats
+{
+    int mis_nodes;
+    int mis_rounds;     // 0 for the greedy sweep
+    double mis_ms;
+    long long missing;  // entries left to the fill-in
+    long long searches; // backbone searches the fill-in ran
+};
 
-    // Find if there has routing table which hasn't been set
+// Find if there has routing table which hasn't been set
+// A missing entry (i, j) is the parent of i in the backbone tree rooted at j,
+// so every column with missing entries is filled from one search, in parallel
+template<class Engine>
+void fill_routing_table(int n,node nodes[],vector<Engine> &engines,thread_pool &pool,build_stats *stats)
+{
+    vector<char> open(n,0);
+    long long missing = 0;
     for(int i=0;i<n;i++)
     {
         for(int j=0;j<n;j++)
         {
             if(nodes[i].sendTo(j) == -1)
             {
-                int tmp = BFS(n,graphex,j,i,CDS,nodes);
-                nodes[i].routing_table_set(j,tmp);
+                open[j] = 1;
+                missing++;
             }
         }
     }
+    vector<int> roots;
+    for(int j=0;j<n;j++)
+    {
+        if(open[j])
+            roots.push_back(j);
+    }
+    pool.run(roots.size(),1,[&](int worker,int k)
+    {
+        int j = roots[k];
+        engines[worker].run(j);
+        const int *last_node = engines[worker].parents();
+        for(int i=0;i<n;i++)
+        {
+            if(nodes[i].sendTo(j) == -1)
+                nodes[i].routing_table_set(j,last_node[i]);
+        }
+    });
+    if(stats != nullptr)
+    {
+        stats->missing = missing;
+        stats->searches = roots.size();
+    }
+    return;
+}
+
+// weight holds one weight per adjacency slot of graph, nullptr when every link counts one hop
+// The backbone is found by hop count either way; the weights only choose the routes over it
+// stats, if given, receives what the MIS and the fill-in did
+void set_routing_table(int n,const csr_graph &graph,node nodes[],thread_pool &pool,const mis_options &mis,
+                       const int *weight = nullptr,build_stats *stats = nullptr)
+{
+    // Initial MIS and CDS
+    vector<int> MIS(n,0),CDS(n,0);
+    auto begin = chrono::steady_clock::now();
+    int rounds = 0;
+    if(mis.luby)
+    {
+        luby_mis luby;
+        luby.build(graph,mis.seed,pool,MIS.data());
+        rounds = luby.rounds;
+    }
+    else
+        build_MIS(n,graph,MIS.data());
+    if(stats != nullptr)
+    {
+        stats->mis_ms = chrono::duration<double,milli>(chrono::steady_clock::now() - begin).count();
+        stats->mis_rounds = rounds;
+        stats->mis_nodes = 0;
+        for(int i=0;i<n;i++)
+            stats->mis_nodes += MIS[i];
+    }
+    build_CDS(n,graph,MIS.data(),CDS.data(),nodes);
+
+    // To avoid BFS into a node which is not CDS
+    // The searches test every link against the CDS mask instead of copying the backbone links
+    node_mask backbone;
+    backbone.build(n,CDS.data());
+    if(weight == nullptr)
+    {
+        vector<masked_bfs_engine> engines(pool.size());
+        for(int i=0; i<pool.size(); i++)
+            engines[i].bind(graph,backbone);
+        set_proxy(n,graph,CDS.data(),nodes,engines,pool);
+        fill_routing_table(n,nodes,engines,pool,stats);
+    }
+    else
+    {
+        vector<dial_engine> engines(pool.size());
+        for(int i=0; i<pool.size(); i++)
+            engines[i].bind(graph,weight,&backbone);
+        set_proxy(n,graph,CDS.data(),nodes,engines,pool);
+        fill_routing_table(n,nodes,engines,pool,stats);
+    }
 /*
     for(int i=0;i<n;i++)
         nodes[i].debug(n);
@@ -253,27 +336,305 @@ void set_routing_table(int n,vector<int> graph[],node nodes[])
 }
 
 
-int main()
+// Apply the link updates in file path: a count, then one "op a b" per line
+// op 1 adds the link a-b and op 0 removes it; an update naming no node is skipped
+// This is not incremental: any link change can move the MIS and so the backbone anywhere
+// in the graph, so the tables are rebuilt from scratch and compared with the old ones to
+// count the changed entries
+bool apply_updates(const char *path,int n,vector<int> &nodeA,vector<int> &nodeB,routing_matrix &table,thread_pool &pool,
+                   const mis_options &mis)
 {
-    int n,links;
-    cin >> n >> links;
-    // Read input links
-    int linkID,nodeA,nodeB;
-    vector<int> graph[n];
-    for(int i=0; i<links; i++)
-    {
-        cin >> linkID >> nodeA >> nodeB;
-        // Save the node i's neighbor in graph[i]
-        graph[nodeA].push_back(nodeB);
-        graph[nodeB].push_back(nodeA);
+    ifstream file(path);
+    if(!file)
+        return false;
+    int count,op,a,b;
+    file >> count;
+    for(int i=0; i<count && file >> op >> a >> b; i++)
+    {
+        if(a < 0 || a >= n || b < 0 || b >= n)
+        {
+            cerr << (op == 1 ? "add" : "remove") << " link " << a << " " << b << ": no such node, skipped" << endl;
+            continue;
+        }
+        if(op == 1)
+        {
+            nodeA.push_back(a);
+            nodeB.push_back(b);
+        }
+        else
+        {
+            for(int j=0; j<(int)nodeA.size(); j++)
+            {
+                if((nodeA[j] == a && nodeB[j] == b) || (nodeA[j] == b && nodeB[j] == a))
+                {
+                    nodeA.erase(nodeA.begin() + j);
+                    nodeB.erase(nodeB.begin() + j);
+                    break;
+                }
+            }
+        }
+        csr_graph graph;
+        graph.build(n,nodeA,nodeB);
+        routing_matrix fresh;
+        fresh.build(n);
+        vector<node> nodes(n);
+        for(int j=0; j<n; j++)
+            nodes[j].initial(j,&fresh);
+        set_routing_table(n,graph,nodes.data(),pool,mis);
+
+        long long changed = 0;
+        for(int x=0; x<n; x++)
+            for(int y=0; y<n; y++)
+                changed += (fresh.get(x,y) != table.get(x,y));
+        table = fresh;
+        cerr << (op == 1 ? "add" : "remove") << " link " << a << " " << b << ": "
+             << changed << " routing entries changed" << endl;
     }
+    return true;
+}
 
-    node nodes[n];
-    // Initial nodes
-    for(int i=0; i<n; i++)
-        nodes[i].initial(n,i);
+// Print the path of one flow by following the routing tables
+void print_flow(node nodes[],int flowID,int source,int dest)
+{
+    out << flowID << " ";
+    while(source != dest)
+    {
+        out << source << " ";
+        source = nodes[source].sendTo(dest);
+    }
+    out << dest << "\n";
+    return;
+}
 
-    set_routing_table(n,graph,nodes);
+int main(int argc,char *argv[])
+{
+    // Read options
+    // --binary F  : read the topology and flows from binary container F instead of stdin
+    // --batch     : load all flows first and answer them on the thread pool
+    // --hops      : print only the hop count of every flow (implies --batch)
+    // --threads N : build the routing tables and answer batched flows with N threads
+    // --updates F : add and remove the links listed in F, rebuilding the routing tables from scratch after each
+    // --weighted  : every link line ends with an integer weight from 0 to 2147483647; route over the lightest backbone paths
+    // --stream    : answer every flow line as soon as it is read and report the latencies at exit
+    // --daemon S  : keep the tables and answer path and next-hop queries on the Unix socket S
+    // --shm NAME  : publish the routing tables in the shared memory segment NAME (e.g. /routes)
+    // --snapshot F: map the routing tables from snapshot F if it matches the topology, else build and save them
+    // --stats     : report the MIS and the backbone searches of the routing table build
+    // --mis M     : greedy (lowest id first, the default) or luby (parallel rounds, reported at exit of the build)
+    // --seed S    : seed of the luby MIS priorities, 1 by default
+    const char *binary_path = nullptr;
+    const char *updates_path = nullptr;
+    bool batch = false,hops_only = false;
+    int threads = 1;
+    bool weighted = false,stream = false;
+    const char *daemon_path = nullptr,*shm_name = nullptr;
+    const char *snapshot_path = nullptr;
+    bool show_stats = false;
+    mis_options mis = {false,1};
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--binary" && i+1 < argc)
+            binary_path = argv[++i];
+        else if(arg == "--batch")
+            batch = true;
+        else if(arg == "--hops")
+            batch = hops_only = true;
+        else if(arg == "--threads" && i+1 < argc)
+            threads = atoi(argv[++i]);
+        else if(arg == "--updates" && i+1 < argc)
+            updates_path = argv[++i];
+        else if(arg == "--weighted")
+            weighted = true;
+        else if(arg == "--stream")
+            stream = true;
+        else if(arg == "--daemon" && i+1 < argc)
+            daemon_path = argv[++i];
+        else if(arg == "--shm" && i+1 < argc)
+            shm_name = argv[++i];
+        else if(arg == "--snapshot" && i+1 < argc)
+            snapshot_path = argv[++i];
+        else if(arg == "--stats")
+            show_stats = true;
+        else if(arg == "--mis" && i+1 < argc)
+        {
+            string kind = argv[++i];
+            if(kind != "greedy" && kind != "luby")
+            {
+                cerr << "--mis is greedy or luby" << endl;
+                return 1;
+            }
+            mis.luby = (kind == "luby");
+        }
+        else if(arg == "--seed" && i+1 < argc)
+            mis.seed = strtoull(argv[++i],nullptr,10);
+    }
+    if(weighted && (binary_path != nullptr || updates_path != nullptr))
+    {
+        cerr << "--binary and --updates carry no link weights and cannot be used with --weighted" << endl;
+        return 1;
+    }
+    if(snapshot_path != nullptr && updates_path != nullptr)
+    {
+        cerr << "--updates changes the routing tables and cannot be used with --snapshot" << endl;
+        return 1;
+    }
+
+    int n;
+    csr_graph graph;
+    vector<int> nodeA,nodeB;
+    vector<int> weight,slot_weight;
+    input_reader in;
+    binary_input bin;
+    if(binary_path != nullptr)
+    {
+        // Use the mapped CSR arrays as the graph
+        if(!bin.open(binary_path,BINARY_FLOWS))
+        {
+            cerr << "cannot load " << binary_path << ": " << bin.error() << endl;
+            return 1;
+        }
+        n = bin.nodes();
+        graph.view(n,bin.offsets(),bin.neighbors());
+    }
+    else
+    {
+        int links;
+        in >> n >> links;
+        if(!in)
+        {
+            cerr << "the input is incomplete" << endl;
+            return 1;
+        }
+        // Read input links
+        int linkID;
+        nodeA.resize(links);
+        nodeB.resize(links);
+        weight.assign(links,1);
+        for(int i=0; i<links; i++)
+        {
+            in >> linkID >> nodeA[i] >> nodeB[i];
+            if(weighted)
+            {
+                long long w;
+                in >> w;
+                if(in && (w < 0 || w > INT_MAX))
+                {
+                    cerr << "link " << linkID << " has weight " << w << ", weights must be from 0 to " << INT_MAX << endl;
+                    return 1;
+                }
+                weight[i] = (int)w;
+            }
+        }
+        if(!in)
+        {
+            cerr << "the input is incomplete" << endl;
+            return 1;
+        }
+        int bad = csr_graph::bad_link(n,nodeA,nodeB);
+        if(bad >= 0)
+        {
+            cerr << "link " << bad << " joins " << nodeA[bad] << " and " << nodeB[bad] << ", node ids must be from 0 to " << n - 1 << endl;
+            return 1;
+        }
+        // Save the node i's neighbor in graph
+        graph.build(n,nodeA,nodeB);
+        // Weights all 1 are plain hop counts, which the BFS handles faster
+        for(int i=0; i<links; i++)
+        {
+            if(weight[i] != 1)
+            {
+                graph.slot_values(nodeA,nodeB,weight,slot_weight);
+                break;
+            }
+        }
+    }
+
+    thread_pool pool(threads);
+    routing_matrix table;
+    vector<node> nodes(n);
+    // A snapshot is only used when it was built from the same topology
+    table_snapshot snapshot;
+    routing_matrix *full = &table;
+    const int *link_weight = slot_weight.empty() ? nullptr : slot_weight.data();
+    uint64_t fingerprint = 0;
+    uint32_t variant = SNAPSHOT_HW2 | (mis.luby ? SNAPSHOT_LUBY : 0);
+    if(snapshot_path != nullptr)
+        fingerprint = topology_fingerprint(graph,link_weight) ^ (mis.luby ? mis.seed * 0x9E3779B97F4A7C15ULL : 0);
+    if(snapshot_path != nullptr && snapshot.open(snapshot_path,variant,fingerprint))
+    {
+        full = &snapshot.table();
+        for(int i=0; i<n; i++)
+            nodes[i].attach(i,full);
+        cerr << "routing tables loaded from " << snapshot_path << endl;
+    }
+    else
+    {
+        table.build(n);
+        // Initial nodes
+        for(int i=0; i<n; i++)
+            nodes[i].initial(i,&table);
+
+        build_stats stats;
+        set_routing_table(n,graph,nodes.data(),pool,mis,link_weight,&stats);
+        if(show_stats || mis.luby)
+        {
+            cerr << (mis.luby ? "luby" : "greedy") << " MIS: " << stats.mis_nodes << " nodes";
+            if(mis.luby)
+                cerr << " in " << stats.mis_rounds << " rounds (seed " << mis.seed << ")";
+            cerr << ", " << stats.mis_ms << " ms" << endl;
+        }
+        if(show_stats)
+        {
+            cerr << "fill-in: " << stats.missing << " missing entries from " << stats.searches
+                 << " backbone searches, " << stats.missing - stats.searches << " searches saved" << endl;
+        }
+        if(snapshot_path != nullptr)
+        {
+            if(save_snapshot(snapshot_path,variant,fingerprint,table))
+                cerr << "routing tables saved to " << snapshot_path << endl;
+            else
+                cerr << "cannot write " << snapshot_path << endl;
+        }
+    }
+
+    // Rebuild the routing tables after every link update
+    if(updates_path != nullptr)
+    {
+        if(binary_path != nullptr)
+            graph.link_list(nodeA,nodeB);
+        if(!apply_updates(updates_path,n,nodeA,nodeB,table,pool,mis))
+        {
+            cerr << "cannot load " << updates_path << endl;
+            return 1;
+        }
+    }
+
+    // Publish the tables and answer queries from other processes instead of reading flows
+    if(shm_name != nullptr || daemon_path != nullptr)
+    {
+#ifndef _WIN32
+        if(shm_name != nullptr)
+        {
+            if(!publish_table(shm_name,*full))
+            {
+                cerr << "cannot publish the routing tables as " << shm_name << endl;
+                return 1;
+            }
+            cerr << "routing tables published as " << shm_name << endl;
+        }
+        if(daemon_path != nullptr)
+        {
+            bool ok = run_route_daemon(daemon_path,*full,n);
+            if(shm_name != nullptr)
+                unpublish_table(shm_name);
+            return ok ? 0 : 1;
+        }
+#else
+        cerr << "--daemon and --shm need POSIX sockets and shared memory" << endl;
+        return 1;
+#endif
+    }
 
 
     for(int i=0; i<n; i++)
@@ -281,21 +642,81 @@ int main()
 
 
     // Read input flows
-    int flows;
-    cin >> flows;
-    int flowID,source,dest;
-    for(int i=0; i<flows; i++)
+    if(stream)
     {
-        cin >> flowID >> source >> dest;
-        cout << flowID << " ";
-
-        // Print answer
-        while(source != dest)
+        // Flows come from stdin even with --binary
+        latency_histogram latency;
+        out.flush();
+        stream_flows(in,out,n,latency,[&](int source,int dest,int)
+        {
+            return (int)nodes[source].sendTo(dest);
+        });
+        cerr << "stream: " << latency.size() << " flows, ";
+        latency.print(cerr);
+        cerr << endl;
+    }
+    else if(batch)
+    {
+        // Load all flows, then answer them on the pool
+        vector<int> flow_list;
+        const int *flows;
+        int flow_count;
+        if(binary_path != nullptr)
+        {
+            flow_count = bin.event_count(0);
+            flows = bin.event(0,0);
+        }
+        else
+        {
+            in >> flow_count;
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            flow_list.resize(3 * flow_count);
+            for(int i=0; i<3*flow_count; i++)
+                in >> flow_list[i];
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            flows = flow_list.data();
+        }
+        answer_flows(flows,flow_count,hops_only,pool,out,[&](int source,int dest,int)
+        {
+            return (int)nodes[source].sendTo(dest);
+        });
+    }
+    else if(binary_path != nullptr)
+    {
+        for(int i=0; i<bin.event_count(0); i++)
+        {
+            const int *flow = bin.event(0,i);
+            print_flow(nodes.data(),flow[0],flow[1],flow[2]);
+        }
+    }
+    else
+    {
+        int flows;
+        in >> flows;
+        if(!in)
+        {
+            cerr << "the flow list is incomplete" << endl;
+            return 1;
+        }
+        int flowID,source,dest;
+        for(int i=0; i<flows; i++)
         {
-            cout << source << " ";
-            source = nodes[source].sendTo(dest);
+            in >> flowID >> source >> dest;
+            if(!in)
+            {
+                cerr << "the flow list is incomplete" << endl;
+                return 1;
+            }
+            print_flow(nodes.data(),flowID,source,dest);
         }
-        cout << dest << "\n";
     }
     return 0;
 }
@@ -4,13 +4,18 @@
 #include <utility>
 #include <climits>
 #include <functional>
-#include <iomanip>
 #include <stack>
 #include <set>
 #include <algorithm>
+#include "../common/binary_format.h"
+#include "../common/input_reader.h"
+#include "../common/output_writer.h"
 
 using namespace std;
 
+// all the output goes through this buffered writer instead of cout
+output_writer out;
+
 #define SET(func_name,type,var_name,_var_name) void func_name(type _var_name) { var_name = _var_name ;}
 #define GET(func_name,type,var_name) type func_name() const { return var_name ;}
 
@@ -84,9 +89,9 @@ public:
         }
         static void print ()
         {
-            cout << "registered header types: " << endl;
+            out << "registered header types: " << "\n";
             for (map<string,header::header_generator*>::iterator it = prototypes.begin(); it != prototypes.end(); it ++)
-                cout << it->second->type() << endl;
+                out << it->second->type() << "\n";
         }
         virtual ~header_generator() {};
     };
@@ -230,9 +235,9 @@ public:
         }
         static void print ()
         {
-            cout << "registered payload types: " << endl;
+            out << "registered payload types: " << "\n";
             for (map<string,payload::payload_generator*>::iterator it = prototypes.begin(); it != prototypes.end(); it ++)
-                cout << it->second->type() << endl;
+                out << it->second->type() << "\n";
         }
         virtual ~payload_generator() {};
     };
@@ -395,9 +400,9 @@ public:
         }
         static void print ()
         {
-            cout << "registered packet types: " << endl;
+            out << "registered packet types: " << "\n";
             for (map<string,packet::packet_generator*>::iterator it = prototypes.begin(); it != prototypes.end(); it ++)
-                cout << it->second->type() << endl;
+                out << it->second->type() << "\n";
         }
         virtual ~packet_generator() {};
     };
@@ -558,9 +563,9 @@ public:
         }
         static void print ()
         {
-            cout << "registered node types: " << endl;
+            out << "registered node types: " << "\n";
             for (map<string,node::node_generator*>::iterator it = prototypes.begin(); it != prototypes.end(); it ++)
-                cout << it->second->type() << endl;
+                out << it->second->type() << "\n";
         }
         virtual ~node_generator() {};
     };
@@ -679,9 +684,9 @@ public:
         }
         static void print ()
         {
-            cout << "registered event types: " << endl;
+            out << "registered event types: " << "\n";
             for (map<string,event::event_generator*>::iterator it = prototypes.begin(); it != prototypes.end(); it ++)
-                cout << it->second->type() << endl;
+                out << it->second->type() << "\n";
         }
         virtual ~event_generator() {}
     };
@@ -695,14 +700,14 @@ unsigned int event::end_time = 0;
 
 void event::flush_events()
 {
-    cout << "**flush begin" << endl;
+    out << "**flush begin" << "\n";
     while ( ! events.empty() )
     {
-        cout << setw(11) << events.top()->trigger_time << ": " << setw(11) << events.top()->event_priority() << endl;
+        out << padded(events.top()->trigger_time,11) << ": " << padded(events.top()->event_priority(),11) << "\n";
         delete events.top();
         events.pop();
     }
-    cout << "**flush end" << endl;
+    out << "**flush end" << "\n";
 }
 event * event::get_next_event()
 {
@@ -850,14 +855,14 @@ unsigned int recv_event::event_priority() const
 // the recv_event::print() function is used for log file
 void recv_event::print () const
 {
-    cout << "time "          << setw(11) << event::getCurTime()
-         << "   recID "      << setw(11) << receiverID
-         << "   pktID"       << setw(11) << pkt->getPacketID()
-         << "   srcID "      << setw(11) << pkt->getHeader()->getSrcID()
-         << "   dstID"       << setw(11) << pkt->getHeader()->getDstID()
-         << "   preID"       << setw(11) << pkt->getHeader()->getPreID()
-         << "   nexID"       << setw(11) << pkt->getHeader()->getNexID()
-         << endl;
+    out << "time "          << padded(event::getCurTime(),11)
+        << "   recID "      << padded(receiverID,11)
+        << "   pktID"       << padded(pkt->getPacketID(),11)
+        << "   srcID "      << padded(pkt->getHeader()->getSrcID(),11)
+        << "   dstID"       << padded(pkt->getHeader()->getDstID(),11)
+        << "   preID"       << padded(pkt->getHeader()->getPreID(),11)
+        << "   nexID"       << padded(pkt->getHeader()->getNexID(),11)
+        << "\n";
 }
 
 class send_event: public event
@@ -951,14 +956,14 @@ unsigned int send_event::event_priority() const
 // the send_event::print() function is used for log file
 void send_event::print () const
 {
-    cout << "time "          << setw(11) << event::getCurTime()
-         << "   senID "      << setw(11) << senderID
-         << "   pktID"       << setw(11) << pkt->getPacketID()
-         << "   srcID "      << setw(11) << pkt->getHeader()->getSrcID()
-         << "   dstID"       << setw(11) << pkt->getHeader()->getDstID()
-         << "   preID"       << setw(11) << pkt->getHeader()->getPreID()
-         << "   nexID"       << setw(11) << pkt->getHeader()->getNexID()
-         << endl;
+    out << "time "          << padded(event::getCurTime(),11)
+        << "   senID "      << padded(senderID,11)
+        << "   pktID"       << padded(pkt->getPacketID(),11)
+        << "   srcID "      << padded(pkt->getHeader()->getSrcID(),11)
+        << "   dstID"       << padded(pkt->getHeader()->getDstID(),11)
+        << "   preID"       << padded(pkt->getHeader()->getPreID(),11)
+        << "   nexID"       << padded(pkt->getHeader()->getNexID(),11)
+        << "\n";
 }
 
 
@@ -1247,9 +1252,9 @@ void LS3D_node::recv_handler (packet *p)
             {
                 unsigned int ans = now_node->get_node_proxy( (pld2->getHostID()));
                 if(ans == BROCAST_ID)
-                    cout << "The proxy of node " << pld2->getHostID() << " not found!" << "\n";
+                    out << "The proxy of node " << pld2->getHostID() << " not found!" << "\n";
                 else
-                    cout << "The proxy of node " << pld2->getHostID() << " is " << ans << "\n";
+                    out << "The proxy of node " << pld2->getHostID() << " is " << ans << "\n";
                 return;
             }
         }
@@ -1267,7 +1272,7 @@ void LS3D_node::recv_handler (packet *p)
                 unsigned int ans = now_node->get_node_proxy( (pld2->getHostID()));
                 if(ans != BROCAST_ID)
                 {
-                    cout << "The proxy of node " << pld2->getHostID() << " is " << ans << "\n";
+                    out << "The proxy of node " << pld2->getHostID() << " is " << ans << "\n";
                     return;
                 }
             }
@@ -1458,8 +1463,24 @@ void LS3D_node::recv_handler (packet *p)
     }
 }
 
-int main()
+int main(int argc,char *argv[])
 {
+    // --binary F : read the topology, publishers and subscribers from binary container F instead of stdin
+    const char *binary_path = nullptr;
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--binary" && i+1 < argc)
+            binary_path = argv[++i];
+    }
+    input_reader in;
+    binary_input bin;
+    if(binary_path != nullptr && !bin.open(binary_path,BINARY_PUBSUB))
+    {
+        cerr << "cannot load " << binary_path << ": " << bin.error() << endl;
+        return 1;
+    }
+
     // header::header_generator::print(); // print all registered headers
     // payload::payload_generator::print(); // print all registered payloads
     // packet::packet_generator::print(); // print all registered packets
@@ -1486,17 +1507,45 @@ int main()
     // READINPUT
     unsigned int nodesCount,links,duration;
     unsigned int linkID,firstNodeID,secondNodeID;
-    cin >> nodesCount >> links >> duration;
+    if (binary_path != nullptr)
+    {
+        nodesCount = bin.nodes();
+        duration = bin.duration();
+    }
+    else
+    {
+        in >> nodesCount >> links >> duration;
+        if (!in)
+        {
+            cerr << "the input is incomplete" << endl;
+            return 1;
+        }
+    }
 
     for (unsigned int id = 0; id < nodesCount; id ++)
     {
         node::node_generator::generate("LS3D_node",id);
     }
-    for(unsigned int i=0; i<links; i++)
+    if (binary_path != nullptr)
+    {
+        // every link is stored in both nodes' neighbor lists
+        for (unsigned int id = 0; id < nodesCount; id ++)
+            for (int e = bin.offsets()[id]; e < bin.offsets()[id+1]; e ++)
+                node::id_to_node(id)->add_phy_neighbor(bin.neighbors()[e]);
+    }
+    else
     {
-        cin >> linkID >> firstNodeID >> secondNodeID;
-        node::id_to_node(firstNodeID)->add_phy_neighbor(secondNodeID);
-        node::id_to_node(secondNodeID)->add_phy_neighbor(firstNodeID);
+        for(unsigned int i=0; i<links; i++)
+        {
+            in >> linkID >> firstNodeID >> secondNodeID;
+            if (!in)
+            {
+                cerr << "the input is incomplete" << endl;
+                return 1;
+            }
+            node::id_to_node(firstNodeID)->add_phy_neighbor(secondNodeID);
+            node::id_to_node(secondNodeID)->add_phy_neighbor(firstNodeID);
+        }
     }
 
     //Use BFS to implement density_count()
@@ -1533,17 +1582,37 @@ int main()
     // read the input and use add_recv_event to add an initial event
     // you can use for loop to read the input
     unsigned int publisherN,subscriberN;
-    cin >> publisherN;
-    for (unsigned int i=0; i<publisherN ; i++)
+    if (binary_path != nullptr)
     {
-        cin >> t >> src >> pro;
-        add_initial_event(true, src, BROCAST_ID, pro, t);
+        for (int i=0; i<bin.event_count(0); i++)
+        {
+            const int *e = bin.event(0,i);
+            add_initial_event(true, e[1], BROCAST_ID, e[2], e[0]);
+        }
+        for (int i=0; i<bin.event_count(1); i++)
+        {
+            const int *e = bin.event(1,i);
+            add_initial_event(false, e[1], e[2], 0, e[0]);
+        }
     }
-    cin >> subscriberN;
-    for (unsigned int i=0; i<subscriberN ; i++)
+    else
     {
-        cin >> t >> src >> dst;
-        add_initial_event(false, src, dst, 0, t);
+        in >> publisherN;
+        for (unsigned int i=0; i<publisherN ; i++)
+        {
+            in >> t >> src >> pro;
+            if (!in)
+                break;
+            add_initial_event(true, src, BROCAST_ID, pro, t);
+        }
+        in >> subscriberN;
+        for (unsigned int i=0; i<subscriberN ; i++)
+        {
+            in >> t >> src >> dst;
+            if (!in)
+                break;
+            add_initial_event(false, src, dst, 0, t);
+        }
     }
     // start simulation!!
     event::start_simulate(duration);
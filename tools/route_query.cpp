@@ -0,0 +1,137 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <climits>
+#include "../common/input_reader.h"
+#include "../common/output_writer.h"
+#include "../common/shared_table.h"
+#include "../common/route_daemon.h"
+using namespace std;
+
+// Ask a running hw1/hw2 daemon for the paths of flows, or read them from its shared tables
+// usage: route_query --socket S < flows.txt      paths from the daemon listening on S
+//        route_query --shm NAME < flows.txt      paths walked in the published tables
+//        route_query --socket S --stop           stop the daemon
+// flows.txt holds one "flowID source dest" per line; the answers look like hw1's
+#ifndef _WIN32
+const int BATCH = 4096;
+
+// Send the flows of one batch as one request and print the paths
+bool ask_daemon(route_client &client,const vector<int> &flows,output_writer &out)
+{
+    int count = flows.size() / 3;
+    vector<uint32_t> pairs(2 * count),reply;
+    for(int i=0; i<count; i++)
+    {
+        pairs[2*i] = flows[3*i+1];
+        pairs[2*i+1] = flows[3*i+2];
+    }
+    if(!client.query(ROUTE_PATH,pairs.data(),count,reply))
+        return false;
+    size_t at = 0;
+    for(int i=0; i<count; i++)
+    {
+        uint32_t length = reply[at++];
+        out << flows[3*i];
+        if(length == 0)
+            out << " unreachable";
+        for(uint32_t k=0; k<length; k++)
+            out << " " << reply[at++];
+        out << "\n";
+    }
+    return true;
+}
+
+int main(int argc,char *argv[])
+{
+    const char *socket_path = nullptr,*shm_name = nullptr;
+    bool stop = false;
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--socket" && i+1 < argc)
+            socket_path = argv[++i];
+        else if(arg == "--shm" && i+1 < argc)
+            shm_name = argv[++i];
+        else if(arg == "--stop")
+            stop = true;
+    }
+    if((socket_path == nullptr) == (shm_name == nullptr))
+    {
+        cerr << "usage: route_query --socket S [--stop] < flows.txt" << endl;
+        cerr << "       route_query --shm NAME < flows.txt" << endl;
+        return 1;
+    }
+
+    route_client client;
+    shared_table shared;
+    if(socket_path != nullptr && !client.connect(socket_path))
+    {
+        cerr << "cannot connect to " << socket_path << endl;
+        return 1;
+    }
+    if(shm_name != nullptr && !shared.open(shm_name))
+    {
+        cerr << "cannot map " << shm_name << endl;
+        return 1;
+    }
+    if(stop)
+        return client.stop() ? 0 : 1;
+
+    output_writer out;
+    input_reader in;
+    vector<int> flows;
+    int values[3],count;
+    while(in.read_line(values,3,count))
+    {
+        if(count != 3)
+            continue;
+        if(shm_name != nullptr)
+        {
+            // Zero-copy lookups straight in the mapped table
+            const routing_matrix &table = shared.table();
+            int source = values[1],dest = values[2];
+            out << values[0];
+            if(source < 0 || source >= table.size() || dest < 0 || dest >= table.size())
+            {
+                out << " invalid\n";
+                continue;
+            }
+            out << " " << source;
+            for(int hops=0; source != dest && hops < table.size(); hops++)
+            {
+                unsigned int next = table.get(source,dest);
+                if(next == routing_matrix::NONE)
+                    break;
+                source = next;
+                out << " " << source;
+            }
+            out << "\n";
+            continue;
+        }
+        flows.insert(flows.end(),values,values + 3);
+        if((int)flows.size() == 3 * BATCH)
+        {
+            if(!ask_daemon(client,flows,out))
+            {
+                cerr << "the daemon went away" << endl;
+                return 1;
+            }
+            flows.clear();
+        }
+    }
+    if(!flows.empty() && !ask_daemon(client,flows,out))
+    {
+        cerr << "the daemon went away" << endl;
+        return 1;
+    }
+    return 0;
+}
+#else
+int main()
+{
+    cerr << "route_query needs POSIX sockets and shared memory" << endl;
+    return 1;
+}
+#endif
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include "../common/graph.h"
+#include "../common/binary_format.h"
+#include "../common/input_reader.h"
+using namespace std;
+
+// Convert a text input into the binary container of common/binary_format.h
+// usage: text2bin [--pubsub] output.bin < input.txt
+//   default  : hw1/hw2 input (n links, links, flows)
+//   --pubsub : hw3 input (n links duration, links, publishers, subscribers)
+int main(int argc,char *argv[])
+{
+    bool pubsub = false;
+    const char *path = nullptr;
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--pubsub")
+            pubsub = true;
+        else
+            path = argv[i];
+    }
+    if(path == nullptr)
+    {
+        cerr << "usage: text2bin [--pubsub] output.bin < input.txt" << endl;
+        return 1;
+    }
+
+    input_reader in;
+    int n,links,duration = 0;
+    in >> n >> links;
+    if(pubsub)
+        in >> duration;
+    int linkID;
+    vector<int> nodeA(links),nodeB(links);
+    for(int i=0; i<links; i++)
+        in >> linkID >> nodeA[i] >> nodeB[i];
+    int bad = csr_graph::bad_link(n,nodeA,nodeB);
+    if(bad >= 0)
+    {
+        cerr << "link " << bad << " joins " << nodeA[bad] << " and " << nodeB[bad] << ", node ids must be from 0 to " << n - 1 << endl;
+        return 1;
+    }
+    csr_graph graph;
+    graph.build(n,nodeA,nodeB);
+
+    // Flows, or publishers then subscribers
+    vector<int> events[2];
+    for(int k=0; k<(pubsub ? 2 : 1); k++)
+    {
+        int count = 0;
+        in >> count;
+        events[k].resize(3 * count);
+        for(int i=0; i<3*count; i++)
+            in >> events[k][i];
+    }
+    if(!in)
+    {
+        cerr << "input is incomplete" << endl;
+        return 1;
+    }
+
+    if(!write_binary(path,pubsub ? BINARY_PUBSUB : BINARY_FLOWS,graph,duration,events))
+    {
+        cerr << "cannot write " << path << endl;
+        return 1;
+    }
+    return 0;
+}